@@ -13,16 +13,48 @@ SOURCES += \
     customlistview.cpp \
     customimagelistview.cpp \
     verify_resources.cpp \
-    texturemanager.cpp \
-    texturebuffer.cpp
+    swimlanenodes.cpp \
+    textureatlas.cpp \
+    titletexturecache.cpp \
+    glyphtext.cpp \
+    postermaterial.cpp \
+    swimlaneanimator.cpp \
+    imagedecoder.cpp \
+    posterscaler.cpp \
+    loadscheduler.cpp \
+    navigationprefetcher.cpp \
+    posterdiskcache.cpp \
+    decodedimagecache.cpp \
+    textureresidencymanager.cpp \
+    fetchservice.cpp \
+    catalogparser.cpp \
+    catalogsnapshot.cpp \
+    layoutengine.cpp \
+    catalogmodel.cpp
 
 HEADERS += \
     customrectangle.h \
     customlistview.h \
     customimagelistview.h \
     verify_resources.h \
-    texturemanager.h \
-    texturebuffer.h
+    swimlanenodes.h \
+    textureatlas.h \
+    titletexturecache.h \
+    glyphtext.h \
+    postermaterial.h \
+    swimlaneanimator.h \
+    imagedecoder.h \
+    posterscaler.h \
+    loadscheduler.h \
+    navigationprefetcher.h \
+    posterdiskcache.h \
+    decodedimagecache.h \
+    textureresidencymanager.h \
+    fetchservice.h \
+    catalogparser.h \
+    catalogsnapshot.h \
+    layoutengine.h \
+    catalogmodel.h
 
 # Resources
 RESOURCES += \
@@ -0,0 +1,22 @@
+# Heap used by the view's items before and after CatalogModel, on a
+# synthetic catalog. Not part of the app build:
+#   qmake benchmarks/catalogmodel && make && ./catalogmodel_benchmark [rows] [items per row]
+QT += core gui
+QT -= widgets
+
+TARGET = catalogmodel_benchmark
+TEMPLATE = app
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp \
+    ../../catalogparser.cpp \
+    ../../catalogmodel.cpp
+
+HEADERS += \
+    ../../catalogparser.h \
+    ../../catalogmodel.h
@@ -0,0 +1,161 @@
+#include "catalogmodel.h"
+#include <QCoreApplication>
+#include <QTextStream>
+#include <QStringList>
+#include <QVector>
+#include <QMap>
+#include <functional>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace {
+// What the view kept per item before CatalogModel
+struct LegacyImageData {
+    QString url;
+    QString title;
+    QString category;
+    QString description;
+    QString id;
+    QString thumbnailUrl;
+    QString programInfo;
+    QString remainingTimeText;
+    QRgb placeholderColor = 0;
+    QMap<QString, QString> links;
+    int sourceOffset = -1;
+    int sourceLength = 0;
+};
+
+// Bytes allocated from the heap, mmapped blocks included; -1 where malloc
+// cannot tell
+qint64 heapBytes()
+{
+#if defined(__GLIBC__)
+#if __GLIBC_PREREQ(2, 33)
+    // mallinfo() counts in int and wraps past 2 GB
+    const struct mallinfo2 info = mallinfo2();
+#else
+    const struct mallinfo info = mallinfo();
+#endif
+    return qint64(info.uordblks) + qint64(info.hblkhd);
+#else
+    return -1;
+#endif
+}
+
+// Rows the way the parser hands them out: every string is an allocation of
+// its own, repeated values included. Episodes of a series share their
+// synopsis, asset types, genres and remaining times repeat.
+QVector<CatalogRow> syntheticCatalog(int rowCount, int itemsPerRow)
+{
+    static const char *const assetTypes[] = { "MOVIE", "EPISODE", "SERIES", "LIVE" };
+    static const char *const genres[] = { "Drama", "Comedy", "Action", "Documentary", "Kids", "Sports" };
+
+    QVector<CatalogRow> rows;
+    int id = 0;
+    for (int r = 0; r < rowCount; ++r) {
+        CatalogRow row;
+        row.classificationId = QString("classification-%1").arg(r);
+        row.title = QString("Row %1").arg(r + 1);
+        for (int i = 0; i < itemsPerRow; ++i, ++id) {
+            CatalogItem item;
+            item.title = QString("Title %1").arg(id);
+            item.url = QString("https://images.example.com/posters/%1/280x420.jpg").arg(id);
+            item.assetType = QString(assetTypes[id % 4]);
+            item.description = QString("Synopsis of series %1, told over a few sentences. ").arg(id / 8).repeated(4);
+            item.programInfo = QString("%1 | %2 | %3 min").arg(2000 + id % 25).arg(genres[id % 6]).arg(45 + id % 4 * 15);
+            item.remainingTimeText = id % 3 ? QString() : QString("%1 days left").arg(1 + id % 30);
+            item.placeholderColor = qRgb(id % 256, id / 256 % 256, 128);
+            item.links.insert(QString("ok").toUpper(), QString("https://api.example.com/assets/%1/play").arg(id));
+            item.links.insert(QString("info").toUpper(), QString("https://api.example.com/assets/%1").arg(id));
+            item.links.insert(QString("play").toUpper(), QString("https://api.example.com/assets/%1/stream").arg(id));
+            if (id % 5 == 0) {
+                item.links.insert(QString("trailer").toUpper(), QString("https://api.example.com/assets/%1/trailer").arg(id));
+            }
+            item.sourceOffset = id * 1500;
+            item.sourceLength = 1400;
+            row.items.append(item);
+        }
+        rows.append(row);
+    }
+    return rows;
+}
+
+// Heap still in use after filling a layout from a fresh catalog and
+// dropping the catalog again
+qint64 retainedBytes(int rowCount, int itemsPerRow, const std::function<void(const QVector<CatalogRow> &)> &fill)
+{
+    const qint64 before = heapBytes();
+    {
+        const QVector<CatalogRow> rows = syntheticCatalog(rowCount, itemsPerRow);
+        fill(rows);
+    }
+    return heapBytes() - before;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    const int rowCount = args.size() > 1 ? qMax(1, args.at(1).toInt()) : 100;
+    const int itemsPerRow = args.size() > 2 ? qMax(1, args.at(2).toInt()) : 100;
+    const int itemCount = rowCount * itemsPerRow;
+
+    QTextStream out(stdout);
+    if (heapBytes() < 0) {
+        out << "heap usage is only measured with glibc\n";
+        return 1;
+    }
+
+    // Filled the way appendCatalogRow() did before and does now
+    QVector<LegacyImageData> legacy;
+    const qint64 legacyBytes = retainedBytes(rowCount, itemsPerRow, [&](const QVector<CatalogRow> &rows) {
+        for (const CatalogRow &row : rows) {
+            for (const CatalogItem &item : row.items) {
+                LegacyImageData imgData;
+                imgData.category = row.title;
+                imgData.title = item.title;
+                imgData.url = item.url;
+                imgData.id = item.assetType;
+                imgData.description = item.description;
+                imgData.programInfo = item.programInfo;
+                imgData.remainingTimeText = item.remainingTimeText;
+                imgData.placeholderColor = item.placeholderColor;
+                imgData.links = item.links;
+                imgData.sourceOffset = item.sourceOffset;
+                imgData.sourceLength = item.sourceLength;
+                legacy.append(imgData);
+            }
+        }
+    });
+
+    CatalogModel model;
+    const qint64 modelBytes = retainedBytes(rowCount, itemsPerRow, [&](const QVector<CatalogRow> &rows) {
+        for (int row = 0; row < rows.size(); ++row) {
+            for (const CatalogItem &item : rows.at(row).items) {
+                model.appendItem(row, item);
+            }
+        }
+    });
+
+    if (model.size() != legacy.size()) {
+        out << "layouts disagree on the item count\n";
+        return 1;
+    }
+    for (int index = 0; index < model.size(); ++index) {
+        const LegacyImageData &imgData = legacy.at(index);
+        if (model.url(index) != imgData.url || model.description(index) != imgData.description
+            || model.link(index, CatalogModel::PlayLink) != imgData.links.value("PLAY")) {
+            out << "layouts disagree at item " << index << "\n";
+            return 1;
+        }
+    }
+
+    out << itemCount << " items in " << rowCount << " rows, heap retained\n"
+        << "  QVector<ImageData>  " << legacyBytes << " bytes, " << legacyBytes / itemCount << " per item\n"
+        << "  CatalogModel        " << modelBytes << " bytes, " << modelBytes / itemCount << " per item, "
+        << model.stringCount() << " distinct strings\n"
+        << "  saved               " << 100 - 100 * modelBytes / qMax<qint64>(1, legacyBytes) << "%\n";
+    return 0;
+}
@@ -0,0 +1,25 @@
+# Compares loading the catalog from JSON with loading it from the binary
+# snapshot. Not part of the app build:
+#   qmake benchmarks/catalogsnapshot && make && ./catalogsnapshot_benchmark [iterations] [catalog.json]
+QT += core gui
+QT -= widgets
+
+TARGET = catalogsnapshot_benchmark
+TEMPLATE = app
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp \
+    ../../catalogparser.cpp \
+    ../../catalogsnapshot.cpp
+
+HEADERS += \
+    ../../catalogparser.h \
+    ../../catalogsnapshot.h
+
+# The same compressed resources the app starts from
+RESOURCES += ../../resources.qrc
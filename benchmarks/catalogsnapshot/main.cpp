@@ -0,0 +1,177 @@
+#include "catalogparser.h"
+#include "catalogsnapshot.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QVector>
+#include <algorithm>
+
+namespace {
+template <typename Function>
+double medianMs(int iterations, Function function)
+{
+    QVector<double> samples;
+    QElapsedTimer timer;
+    for (int i = 0; i < iterations; ++i) {
+        timer.start();
+        function();
+        samples.append(timer.nsecsElapsed() / 1e6);
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples.at(samples.size() / 2);
+}
+
+QByteArray readFile(const QString &path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+// What processJsonData did before the streaming parser: the whole DOM,
+// then the fields the view keeps out of every item
+int parseDom(const QByteArray &data)
+{
+    const QJsonObject root = QJsonDocument::fromJson(data).object();
+    int items = 0;
+    const QJsonArray rows = root["menuItems"].toObject()["items"].toArray();
+    for (const QJsonValue &rowVal : rows) {
+        const QJsonObject row = rowVal.toObject();
+        QString title = row["title"].toString();
+        const QJsonArray rowItems = row["items"].toArray();
+        for (const QJsonValue &itemVal : rowItems) {
+            const QJsonObject item = itemVal.toObject();
+            CatalogItem parsed;
+            parsed.title = item["title"].toString();
+            parsed.url = item["moodImageUri"].toString();
+            parsed.assetType = item["assetType"].toString();
+            parsed.description = item["shortSynopsis"].toString();
+            parsed.programInfo = item["labelProgramInfo"].toString();
+            const QJsonArray links = item["links"].toArray();
+            for (const QJsonValue &link : links) {
+                parsed.links.insert(link.toObject()["event"].toString().toUpper(),
+                                    link.toObject()["href"].toString());
+            }
+            ++items;
+        }
+        Q_UNUSED(title);
+    }
+    return items;
+}
+
+int parseStreaming(const QByteArray &data, bool firstRowOnly)
+{
+    int items = 0;
+    CatalogParser::parseData(data, [&](const CatalogRow &row) {
+        items += row.items.size();
+        return !firstRowOnly;
+    });
+    return items;
+}
+
+// ParseJob::run() without a current snapshot, minus the UI settings:
+// hash the sources, read and parse the JSON, then write the snapshot
+int parseAndWrite(const QString &path, const QString &catalogPath, const QString &settingsPath)
+{
+    const QByteArray catalogHash = CatalogSnapshot::sourceHash(catalogPath);
+    const QByteArray settingsHash = CatalogSnapshot::sourceHash(settingsPath);
+    QVector<CatalogRow> rows;
+    int items = 0;
+    CatalogParser::parseData(readFile(catalogPath), [&](const CatalogRow &row) {
+        rows.append(row);
+        items += row.items.size();
+        return true;
+    });
+    CatalogSnapshot::write(path, catalogHash, settingsHash, rows, QVector<CatalogSnapshot::Dimensions>());
+    return items;
+}
+
+// ParseJob::run() with a current snapshot: the JSON is not read at all
+int loadSnapshot(const QString &path, const QString &catalogPath, const QString &settingsPath)
+{
+    CatalogSnapshot snapshot;
+    if (!snapshot.open(path, CatalogSnapshot::sourceHash(catalogPath),
+                       CatalogSnapshot::sourceHash(settingsPath))) {
+        return -1;
+    }
+    int items = 0;
+    for (int row = 0; row < snapshot.rowCount(); ++row) {
+        items += snapshot.row(row).items.size();
+    }
+    return items;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    const int iterations = args.size() > 1 ? qMax(1, args.at(1).toInt()) : 20;
+    const QString catalogPath = args.size() > 2 ? args.at(2) : QStringLiteral(":/data/embeddedHubMenu.json");
+    const QString settingsPath = QStringLiteral(":/data/uiSettings.json");
+
+    QTextStream out(stdout);
+    const QByteArray json = readFile(catalogPath);
+    if (json.isEmpty()) {
+        out << "cannot read " << catalogPath << "\n";
+        return 1;
+    }
+
+    // The snapshot the app writes after its first parse
+    QTemporaryDir directory;
+    const QString snapshotPath = directory.path() + QStringLiteral("/catalog.snapshot");
+    QVector<CatalogRow> rows;
+    int itemCount = 0;
+    CatalogParser::parseData(json, [&](const CatalogRow &row) {
+        rows.append(row);
+        itemCount += row.items.size();
+        return true;
+    });
+    if (!CatalogSnapshot::write(snapshotPath, CatalogSnapshot::sourceHash(catalogPath),
+                                CatalogSnapshot::sourceHash(settingsPath), rows,
+                                QVector<CatalogSnapshot::Dimensions>())) {
+        out << "cannot write " << snapshotPath << "\n";
+        return 1;
+    }
+    if (loadSnapshot(snapshotPath, catalogPath, settingsPath) != itemCount) {
+        out << "snapshot and JSON disagree\n";
+        return 1;
+    }
+
+    out << catalogPath << ": " << rows.size() << " rows, " << itemCount << " items, "
+        << json.size() << " bytes JSON, " << QFileInfo(snapshotPath).size() << " bytes snapshot\n"
+        << iterations << " iterations, median ms\n";
+
+    const double readMs = medianMs(iterations, [&]() { readFile(catalogPath); });
+    const double domMs = medianMs(iterations, [&]() { parseDom(json); });
+    const double streamMs = medianMs(iterations, [&]() { parseStreaming(json, false); });
+    const double firstRowMs = medianMs(iterations, [&]() { parseStreaming(json, true); });
+    const double hashMs = medianMs(iterations, [&]() {
+        CatalogSnapshot::sourceHash(catalogPath);
+        CatalogSnapshot::sourceHash(settingsPath);
+    });
+    const QString rewritePath = directory.path() + QStringLiteral("/rewrite.snapshot");
+    const double firstStartMs = medianMs(iterations, [&]() {
+        parseAndWrite(rewritePath, catalogPath, settingsPath);
+    });
+    const double snapshotMs = medianMs(iterations, [&]() {
+        loadSnapshot(snapshotPath, catalogPath, settingsPath);
+    });
+
+    out << "parse\n"
+        << "  read + inflate        " << readMs << "\n"
+        << "  JSON DOM              " << domMs << "\n"
+        << "  JSON streaming        " << streamMs << "  x" << domMs / streamMs << "\n"
+        << "  JSON first row        " << firstRowMs << "\n"
+        << "startup, catalog to rows as the parser's worker does it\n"
+        << "  JSON DOM, before      " << readMs + domMs << "\n"
+        << "  JSON + snapshot write " << firstStartMs << "\n"
+        << "  snapshot, no JSON     " << snapshotMs << "  x" << (readMs + domMs) / snapshotMs << "\n"
+        << "    of which hashing    " << hashMs << "\n";
+    return 0;
+}
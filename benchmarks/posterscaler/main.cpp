@@ -0,0 +1,108 @@
+#include "posterscaler.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QTextStream>
+#include <algorithm>
+
+namespace {
+// Smooth gradients with some noise, closer to a photo than random bytes
+QImage makeSource(const QSize &size, QImage::Format format)
+{
+    QImage image(size, QImage::Format_RGB32);
+    quint32 seed = 1;
+    for (int y = 0; y < size.height(); ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < size.width(); ++x) {
+            seed = seed * 1103515245u + 12345u;
+            const int noise = int((seed >> 16) & 31) - 16;
+            line[x] = qRgb(qBound(0, x * 255 / size.width() + noise, 255),
+                           qBound(0, y * 255 / size.height() + noise, 255),
+                           qBound(0, (x + y) * 255 / (size.width() + size.height()) - noise, 255));
+        }
+    }
+    return image.convertToFormat(format);
+}
+
+template <typename Function>
+double medianMs(int iterations, Function function)
+{
+    QVector<double> samples;
+    QElapsedTimer timer;
+    for (int i = 0; i < iterations; ++i) {
+        timer.start();
+        function();
+        samples.append(timer.nsecsElapsed() / 1e6);
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples.at(samples.size() / 2);
+}
+
+int maxDifference(const QImage &a, const QImage &b)
+{
+    const QImage left = a.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
+    const QImage right = b.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
+    int result = 0;
+    for (int y = 0; y < left.height(); ++y) {
+        const uchar *l = left.constScanLine(y);
+        const uchar *r = right.constScanLine(y);
+        for (int x = 0; x < left.width() * 4; ++x) {
+            result = qMax(result, qAbs(int(l[x]) - int(r[x])));
+        }
+    }
+    return result;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const int iterations = app.arguments().size() > 1 ? qMax(1, app.arguments().at(1).toInt()) : 20;
+
+    // Full size S3 mood image, the same after a 1/4 scaled IDCT, and the
+    // two poster shapes
+    const QList<QSize> sources = { QSize(2733, 3901), QSize(684, 976) };
+    const QList<QSize> posters = { QSize(152, 228), QSize(240, 135) };
+    const QList<QImage::Format> formats = { QImage::Format_RGB32, QImage::Format_RGB888 };
+    const QList<PosterScaler::Kernel> kernels = {
+        PosterScaler::Scalar, PosterScaler::Sse41, PosterScaler::Avx2, PosterScaler::Neon
+    };
+
+    QTextStream out(stdout);
+    out << "best kernel: " << PosterScaler::kernelName(PosterScaler::bestKernel())
+        << ", " << iterations << " iterations, median ms\n";
+
+    for (const QSize &sourceSize : sources) {
+        for (QImage::Format format : formats) {
+            const QImage source = makeSource(sourceSize, format);
+            for (const QSize &poster : posters) {
+                const QSize size = sourceSize.scaled(poster, Qt::KeepAspectRatio);
+                out << sourceSize.width() << "x" << sourceSize.height()
+                    << (format == QImage::Format_RGB32 ? " RGB32" : " RGB888")
+                    << " -> " << size.width() << "x" << size.height() << "\n";
+
+                // What processLoadedImage did before the decode pipeline
+                QImage reference;
+                const double qtMs = medianMs(iterations, [&]() {
+                    reference = source.convertToFormat(QImage::Format_RGBA8888)
+                                      .scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+                });
+                out << "  qt convert+scaled  " << qtMs << "\n";
+
+                for (PosterScaler::Kernel kernel : kernels) {
+                    if (!PosterScaler::isSupported(kernel)) {
+                        continue;
+                    }
+                    QImage result;
+                    const double ms = medianMs(iterations, [&]() {
+                        result = PosterScaler::scaled(source, size, kernel);
+                    });
+                    out << "  " << QString(PosterScaler::kernelName(kernel)).leftJustified(18)
+                        << ms << "  x" << qtMs / ms
+                        << "  max diff " << maxDifference(reference, result) << "\n";
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,24 @@
+# Compares PosterScaler with the convertToFormat() + QImage::scaled() path
+# it replaced. Not part of the app build:
+#   qmake benchmarks/posterscaler && make && ./posterscaler_benchmark [iterations]
+QT += core gui
+QT -= widgets
+
+TARGET = posterscaler_benchmark
+TEMPLATE = app
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp \
+    ../../posterscaler.cpp
+
+HEADERS += \
+    ../../posterscaler.h
+
+linux-rasp-pi-* {
+    QMAKE_CXXFLAGS += -mfpu=neon-vfpv4 -mfloat-abi=hard
+}
@@ -0,0 +1,93 @@
+#include "catalogmodel.h"
+
+int CatalogModel::linkForEvent(const QString &event)
+{
+    for (int link = 0; link < LinkCount; ++link) {
+        if (event == eventName(Link(link))) {
+            return link;
+        }
+    }
+    return -1;
+}
+
+QString CatalogModel::eventName(Link link)
+{
+    switch (link) {
+    case OkLink:
+        return QStringLiteral("OK");
+    case InfoLink:
+        return QStringLiteral("INFO");
+    case PlayLink:
+        return QStringLiteral("PLAY");
+    default:
+        return QString();
+    }
+}
+
+CatalogModel::CatalogModel()
+{
+    clear();
+}
+
+void CatalogModel::clear()
+{
+    // Id 0 is the empty string, for missing fields and links
+    m_strings.clear();
+    m_stringIds.clear();
+    intern(QString());
+
+    m_rows.clear();
+    m_titles.clear();
+    m_urls.clear();
+    m_assetTypes.clear();
+    m_descriptions.clear();
+    m_programInfos.clear();
+    m_remainingTimeTexts.clear();
+    m_placeholderColors.clear();
+    m_links.clear();
+    m_sourceOffsets.clear();
+    m_sourceLengths.clear();
+}
+
+void CatalogModel::appendItem(int row, const CatalogItem &item)
+{
+    m_rows.append(row);
+    m_titles.append(intern(item.title));
+    m_urls.append(intern(item.url));
+    m_assetTypes.append(intern(item.assetType));
+    m_descriptions.append(intern(item.description));
+    m_programInfos.append(intern(item.programInfo));
+    m_remainingTimeTexts.append(intern(item.remainingTimeText));
+    m_placeholderColors.append(item.placeholderColor);
+    m_sourceOffsets.append(item.sourceOffset);
+    m_sourceLengths.append(item.sourceLength);
+
+    const int first = m_links.size();
+    m_links.resize(first + LinkCount);
+    for (auto it = item.links.constBegin(); it != item.links.constEnd(); ++it) {
+        const int link = linkForEvent(it.key());
+        if (link >= 0) {
+            m_links[first + link] = intern(it.value());
+        }
+    }
+}
+
+const QString &CatalogModel::link(int index, Link link) const
+{
+    if (index < 0 || index >= size() || link < 0 || link >= LinkCount) {
+        return m_strings[0];
+    }
+    return m_strings[m_links[index * LinkCount + link]];
+}
+
+quint32 CatalogModel::intern(const QString &string)
+{
+    auto it = m_stringIds.constFind(string);
+    if (it != m_stringIds.constEnd()) {
+        return it.value();
+    }
+    const quint32 id = m_strings.size();
+    m_strings.append(string);
+    m_stringIds.insert(string, id);
+    return id;
+}
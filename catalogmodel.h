@@ -0,0 +1,82 @@
+#ifndef CATALOGMODEL_H
+#define CATALOGMODEL_H
+
+#include "catalogparser.h"
+#include <QVector>
+#include <QHash>
+#include <QString>
+#include <QRgb>
+
+// The items the view shows, one array per field indexed by item index
+// instead of one struct per item.
+//
+// Items refer to their row by its index in the view's row titles, never
+// by name. Every string is an id into a table of distinct strings, so
+// asset types, program info, remaining time texts and synopses shared by
+// episodes are held once. Of the links only the events the view acts on
+// are kept, each in a fixed slot.
+//
+// Items are appended row by row, so each row owns a contiguous index
+// range. String accessors read out of range indices as empty.
+class CatalogModel
+{
+public:
+    enum Link {
+        OkLink,
+        InfoLink,
+        PlayLink,
+        LinkCount
+    };
+
+    // Slot of an upper case link event, -1 for events that are not kept
+    static int linkForEvent(const QString &event);
+    static QString eventName(Link link);
+
+    CatalogModel();
+
+    void clear();
+    void appendItem(int row, const CatalogItem &item);
+
+    int size() const { return m_rows.size(); }
+    bool isEmpty() const { return m_rows.isEmpty(); }
+    // Distinct strings, the empty one included
+    int stringCount() const { return m_strings.size(); }
+
+    int row(int index) const { return m_rows[index]; }
+    const QString &title(int index) const { return string(m_titles, index); }
+    const QString &url(int index) const { return string(m_urls, index); }
+    const QString &assetType(int index) const { return string(m_assetTypes, index); }
+    const QString &description(int index) const { return string(m_descriptions, index); }
+    const QString &programInfo(int index) const { return string(m_programInfos, index); }
+    const QString &remainingTimeText(int index) const { return string(m_remainingTimeTexts, index); }
+    QRgb placeholderColor(int index) const { return m_placeholderColors[index]; }
+    // Empty if the item has no such link
+    const QString &link(int index, Link link) const;
+    // Byte range of the item in the catalog JSON, offset -1 if unknown
+    int sourceOffset(int index) const { return m_sourceOffsets[index]; }
+    int sourceLength(int index) const { return m_sourceLengths[index]; }
+
+private:
+    quint32 intern(const QString &string);
+    const QString &string(const QVector<quint32> &ids, int index) const {
+        return m_strings[index >= 0 && index < ids.size() ? ids[index] : 0];
+    }
+
+    QVector<QString> m_strings;
+    QHash<QString, quint32> m_stringIds;
+
+    QVector<int> m_rows;
+    QVector<quint32> m_titles;
+    QVector<quint32> m_urls;
+    QVector<quint32> m_assetTypes;
+    QVector<quint32> m_descriptions;
+    QVector<quint32> m_programInfos;
+    QVector<quint32> m_remainingTimeTexts;
+    QVector<QRgb> m_placeholderColors;
+    // LinkCount string ids per item
+    QVector<quint32> m_links;
+    QVector<int> m_sourceOffsets;
+    QVector<int> m_sourceLengths;
+};
+
+#endif // CATALOGMODEL_H
@@ -0,0 +1,723 @@
+#include "catalogparser.h"
+#include <QRunnable>
+#include <QFile>
+#include <QColor>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QStack>
+#include <QStringList>
+#include <QDebug>
+#include <cctype>
+
+namespace {
+// Deeper nesting than any menu has, keeps skipValue() off the end of the stack
+const int MAX_DEPTH = 256;
+
+// Pull parser over a complete JSON buffer: the caller walks the structure
+// it expects and skips the rest, nothing is allocated for skipped values.
+// Containers are entered explicitly; nextKey() and nextElement() return
+// false at the closing bracket. Any syntax error sticks, every call after
+// it fails.
+class JsonReader
+{
+public:
+    enum Type { Object, Array, String, Number, Bool, Null, Invalid };
+
+    explicit JsonReader(const QByteArray &data)
+        : m_begin(data.constData())
+        , m_pos(data.constData())
+        , m_end(data.constData() + data.size())
+        , m_failed(false)
+    {
+    }
+
+    bool hasFailed() const { return m_failed; }
+    bool atEnd() { skipSpace(); return m_pos >= m_end; }
+    // Byte offset the reader is at, right behind the last token read
+    // or at the token peek() looked at
+    int position() const { return int(m_pos - m_begin); }
+
+    Type peek()
+    {
+        skipSpace();
+        if (m_failed || m_pos >= m_end) {
+            return Invalid;
+        }
+        switch (*m_pos) {
+        case '{': return Object;
+        case '[': return Array;
+        case '"': return String;
+        case 't': case 'f': return Bool;
+        case 'n': return Null;
+        case '-': case '0': case '1': case '2': case '3': case '4':
+        case '5': case '6': case '7': case '8': case '9': return Number;
+        default: return Invalid;
+        }
+    }
+
+    bool enterObject() { return enter('{'); }
+    bool enterArray() { return enter('['); }
+
+    bool nextKey(QString *key)
+    {
+        return nextMember('}') && readString(key) && expect(':');
+    }
+
+    bool nextElement() { return nextMember(']'); }
+
+    bool readString(QString *out)
+    {
+        if (!expect('"')) {
+            return false;
+        }
+        const char *start = m_pos;
+        while (m_pos < m_end && *m_pos != '"' && *m_pos != '\\') {
+            ++m_pos;
+        }
+        if (m_pos >= m_end) {
+            return fail();
+        }
+        if (*m_pos == '"') {
+            // Most strings have no escapes and convert straight from the buffer
+            *out = QString::fromUtf8(start, int(m_pos - start));
+            ++m_pos;
+            return true;
+        }
+
+        QByteArray utf8(start, int(m_pos - start));
+        while (m_pos < m_end && *m_pos != '"') {
+            if (*m_pos != '\\') {
+                utf8.append(*m_pos++);
+                continue;
+            }
+            if (++m_pos >= m_end) {
+                return fail();
+            }
+            switch (*m_pos++) {
+            case '"': utf8.append('"'); break;
+            case '\\': utf8.append('\\'); break;
+            case '/': utf8.append('/'); break;
+            case 'b': utf8.append('\b'); break;
+            case 'f': utf8.append('\f'); break;
+            case 'n': utf8.append('\n'); break;
+            case 'r': utf8.append('\r'); break;
+            case 't': utf8.append('\t'); break;
+            case 'u': {
+                uint code = 0;
+                if (!readHex4(&code)) {
+                    return false;
+                }
+                if (QChar::isHighSurrogate(code) && m_end - m_pos >= 6
+                    && m_pos[0] == '\\' && m_pos[1] == 'u') {
+                    m_pos += 2;
+                    uint low = 0;
+                    if (!readHex4(&low)) {
+                        return false;
+                    }
+                    code = QChar::surrogateToUcs4(ushort(code), ushort(low));
+                }
+                utf8.append(QString::fromUcs4(&code, 1).toUtf8());
+                break;
+            }
+            default:
+                return fail();
+            }
+        }
+        if (!expect('"')) {
+            return false;
+        }
+        *out = QString::fromUtf8(utf8);
+        return true;
+    }
+
+    // Strings, numbers, booleans and null; containers are skipped and
+    // come back undefined
+    bool readScalar(QJsonValue *out)
+    {
+        switch (peek()) {
+        case String: {
+            QString text;
+            if (!readString(&text)) {
+                return false;
+            }
+            *out = text;
+            return true;
+        }
+        case Number: {
+            const char *start = m_pos;
+            while (m_pos < m_end && (isdigit(uchar(*m_pos)) || *m_pos == '-' || *m_pos == '+'
+                                     || *m_pos == '.' || *m_pos == 'e' || *m_pos == 'E')) {
+                ++m_pos;
+            }
+            bool ok = false;
+            const double number = QByteArray(start, int(m_pos - start)).toDouble(&ok);
+            if (!ok) {
+                return fail();
+            }
+            *out = number;
+            return true;
+        }
+        case Bool:
+            if (literal("true")) {
+                *out = true;
+                return true;
+            }
+            if (literal("false")) {
+                *out = false;
+                return true;
+            }
+            return fail();
+        case Null:
+            *out = QJsonValue();
+            return literal("null") || fail();
+        case Object:
+        case Array:
+            *out = QJsonValue(QJsonValue::Undefined);
+            return skipValue();
+        default:
+            return fail();
+        }
+    }
+
+    bool skipValue()
+    {
+        switch (peek()) {
+        case Object: {
+            if (!enterObject()) {
+                return false;
+            }
+            while (nextMember('}')) {
+                if (!skipString() || !expect(':') || !skipValue()) {
+                    return false;
+                }
+            }
+            return !m_failed;
+        }
+        case Array:
+            if (!enterArray()) {
+                return false;
+            }
+            while (nextElement()) {
+                if (!skipValue()) {
+                    return false;
+                }
+            }
+            return !m_failed;
+        case String:
+            return skipString();
+        default: {
+            QJsonValue ignored;
+            return readScalar(&ignored);
+        }
+        }
+    }
+
+private:
+    bool fail()
+    {
+        m_failed = true;
+        return false;
+    }
+
+    void skipSpace()
+    {
+        while (m_pos < m_end && (*m_pos == ' ' || *m_pos == '\n' || *m_pos == '\r' || *m_pos == '\t')) {
+            ++m_pos;
+        }
+    }
+
+    bool expect(char c)
+    {
+        skipSpace();
+        if (m_failed || m_pos >= m_end || *m_pos != c) {
+            return fail();
+        }
+        ++m_pos;
+        return true;
+    }
+
+    bool literal(const char *text)
+    {
+        const int length = int(qstrlen(text));
+        if (m_end - m_pos < length || qstrncmp(m_pos, text, uint(length)) != 0) {
+            return false;
+        }
+        m_pos += length;
+        return true;
+    }
+
+    bool readHex4(uint *out)
+    {
+        if (m_end - m_pos < 4) {
+            return fail();
+        }
+        bool ok = false;
+        *out = QByteArray(m_pos, 4).toUInt(&ok, 16);
+        m_pos += 4;
+        return ok || fail();
+    }
+
+    bool skipString()
+    {
+        if (!expect('"')) {
+            return false;
+        }
+        while (m_pos < m_end && *m_pos != '"') {
+            if (*m_pos == '\\' && ++m_pos >= m_end) {
+                break;
+            }
+            ++m_pos;
+        }
+        if (m_pos >= m_end) {
+            return fail();
+        }
+        ++m_pos;
+        return true;
+    }
+
+    bool enter(char open)
+    {
+        if (m_first.size() >= MAX_DEPTH || !expect(open)) {
+            return fail();
+        }
+        m_first.push(true);
+        return true;
+    }
+
+    // Moves to the next member of the open container, consuming the comma
+    // in between, or leaves the container at close
+    bool nextMember(char close)
+    {
+        skipSpace();
+        if (m_failed || m_first.isEmpty() || m_pos >= m_end) {
+            return fail();
+        }
+        if (*m_pos == close) {
+            ++m_pos;
+            m_first.pop();
+            return false;
+        }
+        if (!m_first.top() && !expect(',')) {
+            return false;
+        }
+        m_first.top() = false;
+        return true;
+    }
+
+    const char *m_begin;
+    const char *m_pos;
+    const char *m_end;
+    QStack<bool> m_first;   // per open container, no member read yet
+    bool m_failed;
+};
+
+// Fills {{=field}} placeholders from the item. Returns an empty string when
+// a field is missing, so half resolved templates never reach the screen.
+QString resolveItemTemplate(const QString &text, const QJsonObject &item)
+{
+    QString result = text;
+    int start = result.indexOf(QLatin1String("{{="));
+    while (start >= 0) {
+        int end = result.indexOf(QLatin1String("}}"), start);
+        if (end < 0) {
+            return QString();
+        }
+        QJsonValue value = item.value(result.mid(start + 3, end - start - 3).trimmed());
+        if (value.isUndefined() || value.isNull()) {
+            return QString();
+        }
+        QString replacement = value.isDouble() ? QString::number(value.toDouble()) : value.toString();
+        result.replace(start, end + 2 - start, replacement);
+        start = result.indexOf(QLatin1String("{{="), start + replacement.size());
+    }
+    return result;
+}
+
+bool parseLinks(JsonReader &reader, QMap<QString, QString> *links)
+{
+    if (reader.peek() != JsonReader::Array) {
+        return reader.skipValue();
+    }
+    reader.enterArray();
+    while (reader.nextElement()) {
+        if (reader.peek() != JsonReader::Object) {
+            if (!reader.skipValue()) {
+                return false;
+            }
+            continue;
+        }
+        reader.enterObject();
+        QString href;
+        QString event;
+        QStringList events;
+        QString key;
+        while (reader.nextKey(&key)) {
+            QJsonValue value;
+            if (key == QLatin1String("events") && reader.peek() == JsonReader::Array) {
+                reader.enterArray();
+                while (reader.nextElement()) {
+                    if (!reader.readScalar(&value)) {
+                        return false;
+                    }
+                    events.append(value.toString());
+                }
+            } else if (!reader.readScalar(&value)) {
+                return false;
+            } else if (key == QLatin1String("href")) {
+                href = value.toString();
+            } else if (key == QLatin1String("event")) {
+                event = value.toString();
+            }
+        }
+        if (reader.hasFailed()) {
+            return false;
+        }
+        // An events array wins over a single event
+        if (events.isEmpty() && !event.isEmpty()) {
+            events.append(event);
+        }
+        for (const QString &type : events) {
+            links->insert(type.toUpper(), href);
+        }
+    }
+    return !reader.hasFailed();
+}
+
+// False on a syntax error; *keep is false for items the view does not show
+bool parseItem(JsonReader &reader, int itemNumber, CatalogItem *item, bool *keep)
+{
+    *keep = false;
+    if (reader.peek() != JsonReader::Object) {
+        return reader.skipValue();
+    }
+    const int begin = reader.position();
+    reader.enterObject();
+
+    // Top level scalars only, they are all templates can refer to
+    QJsonObject fields;
+    QString key;
+    while (reader.nextKey(&key)) {
+        if (key == QLatin1String("links")) {
+            if (!parseLinks(reader, &item->links)) {
+                return false;
+            }
+            continue;
+        }
+        QJsonValue value;
+        if (!reader.readScalar(&value)) {
+            return false;
+        }
+        if (!value.isUndefined()) {
+            fields.insert(key, value);
+        }
+    }
+    if (reader.hasFailed()) {
+        return false;
+    }
+    // The view hands out the item's original JSON from here
+    item->sourceOffset = begin;
+    item->sourceLength = reader.position() - begin;
+
+    item->assetType = fields.value(QLatin1String("assetType")).toString();
+    if (item->assetType == QLatin1String("viewAll")) {
+        return true;
+    }
+    *keep = true;
+
+    item->title = fields.value(QLatin1String("title")).toString();
+    // Mood image first, the thumbnail is the fallback
+    item->url = fields.value(QLatin1String("moodImageUri")).toString();
+    if (item->url.isEmpty()) {
+        item->url = fields.value(QLatin1String("thumbnailUri")).toString();
+    }
+    if (item->url.startsWith(QLatin1String("//"))) {
+        item->url.prepend(QLatin1String("https:"));
+    }
+    if (item->url.isEmpty()) {
+        item->url = QString(":/data/images/img%1.jpg").arg(itemNumber % 5 + 1);
+    }
+    item->description = fields.value(QLatin1String("shortSynopsis")).toString();
+    item->programInfo = fields.value(QLatin1String("labelProgramInfo")).toString();
+    item->remainingTimeText = resolveItemTemplate(fields.value(QLatin1String("remainingTimeText")).toString(),
+                                                  fields);
+    const QColor dominantColor(fields.value(QLatin1String("dominantColor")).toString());
+    if (dominantColor.isValid()) {
+        item->placeholderColor = dominantColor.rgb();
+    }
+    return true;
+}
+
+bool parseRow(JsonReader &reader, int *itemCount, CatalogRow *row)
+{
+    if (reader.peek() != JsonReader::Object) {
+        return reader.skipValue();
+    }
+    reader.enterObject();
+    QString key;
+    while (reader.nextKey(&key)) {
+        if (key == QLatin1String("items") && reader.peek() == JsonReader::Array) {
+            reader.enterArray();
+            while (reader.nextElement()) {
+                CatalogItem item;
+                bool keep = false;
+                if (!parseItem(reader, *itemCount, &item, &keep)) {
+                    return false;
+                }
+                if (keep) {
+                    row->items.append(item);
+                    ++*itemCount;
+                }
+            }
+            continue;
+        }
+        QJsonValue value;
+        if (!reader.readScalar(&value)) {
+            return false;
+        }
+        if (key == QLatin1String("title")) {
+            row->title = value.toString();
+        } else if (key == QLatin1String("classificationId")) {
+            row->classificationId = value.toString();
+        }
+    }
+    return !reader.hasFailed();
+}
+
+QByteArray readCatalog(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Failed to open catalog" << path << file.errorString();
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+class ParseJob : public QRunnable
+{
+public:
+    ParseJob(CatalogParser *parser, quint64 ticket, const QSharedPointer<QAtomicInt> &cancelled,
+             const QString &path, const QString &settingsPath,
+             const CatalogParser::SettingsReader &readSettings)
+        : m_parser(parser)
+        , m_ticket(ticket)
+        , m_cancelled(cancelled)
+        , m_path(path)
+        , m_settingsPath(settingsPath)
+        , m_readSettings(readSettings)
+    {
+    }
+
+    void run() override
+    {
+        const QByteArray catalogHash = CatalogSnapshot::sourceHash(m_path);
+        const QByteArray settingsHash = CatalogSnapshot::sourceHash(m_settingsPath);
+        const QString snapshotPath = CatalogSnapshot::defaultPath(m_path);
+        if (loadSnapshot(snapshotPath, catalogHash, settingsHash)) {
+            // The JSON is only read if someone asks for it, see readSource()
+            finish(true, QByteArray());
+            return;
+        }
+
+        const QVector<CatalogSnapshot::Dimensions> dimensions = m_readSettings(m_settingsPath);
+        postDimensions(dimensions, false);
+
+        const QByteArray data = readCatalog(m_path);
+        QVector<CatalogRow> rows;
+        const bool ok = !data.isEmpty() && CatalogParser::parseData(data, [this, &rows](const CatalogRow &row) {
+            if (m_cancelled->load()) {
+                return false;
+            }
+            rows.append(row);
+            postRow(row);
+            return true;
+        });
+
+        // A cancelled parse stops early without an error, it is incomplete
+        if (ok && !rows.isEmpty() && !m_cancelled->load()) {
+            CatalogSnapshot::write(snapshotPath, catalogHash, settingsHash, rows, dimensions);
+        }
+        finish(ok, data);
+    }
+
+private:
+    bool loadSnapshot(const QString &path, const QByteArray &catalogHash, const QByteArray &settingsHash)
+    {
+        CatalogSnapshot snapshot;
+        if (!snapshot.open(path, catalogHash, settingsHash)) {
+            return false;
+        }
+        postDimensions(snapshot.dimensions(), true);
+        for (int row = 0; row < snapshot.rowCount() && !m_cancelled->load(); ++row) {
+            postRow(snapshot.row(row));
+        }
+        return true;
+    }
+
+    // The parser waits for the pool before it goes away
+    void postDimensions(const QVector<CatalogSnapshot::Dimensions> &dimensions, bool fromSnapshot)
+    {
+        QMetaObject::invokeMethod(m_parser, "onJobDimensions", Qt::QueuedConnection,
+                                  Q_ARG(quint64, m_ticket),
+                                  Q_ARG(QVector<CatalogSnapshot::Dimensions>, dimensions),
+                                  Q_ARG(bool, fromSnapshot));
+    }
+
+    void postRow(const CatalogRow &row)
+    {
+        QMetaObject::invokeMethod(m_parser, "onJobRow", Qt::QueuedConnection,
+                                  Q_ARG(quint64, m_ticket), Q_ARG(CatalogRow, row));
+    }
+
+    void finish(bool ok, const QByteArray &data)
+    {
+        QMetaObject::invokeMethod(m_parser, "onJobFinished", Qt::QueuedConnection,
+                                  Q_ARG(quint64, m_ticket), Q_ARG(bool, ok),
+                                  Q_ARG(QByteArray, data));
+    }
+
+    CatalogParser *m_parser;
+    quint64 m_ticket;
+    QSharedPointer<QAtomicInt> m_cancelled;
+    QString m_path;
+    QString m_settingsPath;
+    CatalogParser::SettingsReader m_readSettings;
+};
+
+class ReadJob : public QRunnable
+{
+public:
+    ReadJob(CatalogParser *parser, quint64 ticket, const QString &path)
+        : m_parser(parser)
+        , m_ticket(ticket)
+        , m_path(path)
+    {
+    }
+
+    void run() override
+    {
+        QMetaObject::invokeMethod(m_parser, "onJobSourceRead", Qt::QueuedConnection,
+                                  Q_ARG(quint64, m_ticket), Q_ARG(QByteArray, readCatalog(m_path)));
+    }
+
+private:
+    CatalogParser *m_parser;
+    quint64 m_ticket;
+    QString m_path;
+};
+}
+
+CatalogParser::CatalogParser(QObject *parent)
+    : QObject(parent)
+    , m_ticket(0)
+    , m_readTicket(0)
+    , m_nextTicket(0)
+{
+    qRegisterMetaType<CatalogRow>();
+    qRegisterMetaType<QVector<CatalogSnapshot::Dimensions> >();
+    m_pool.setMaxThreadCount(1);
+}
+
+CatalogParser::~CatalogParser()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+void CatalogParser::load(const QString &path, const QString &settingsPath,
+                         const SettingsReader &readSettings)
+{
+    cancel();
+    m_ticket = ++m_nextTicket;
+    m_cancelled = QSharedPointer<QAtomicInt>::create(0);
+    m_pool.start(new ParseJob(this, m_ticket, m_cancelled, path, settingsPath, readSettings));
+}
+
+void CatalogParser::readSource(const QString &path)
+{
+    m_readTicket = ++m_nextTicket;
+    m_pool.start(new ReadJob(this, m_readTicket, path));
+}
+
+void CatalogParser::cancel()
+{
+    if (m_cancelled) {
+        m_cancelled->store(1);
+        m_cancelled.clear();
+    }
+    m_ticket = 0;
+    m_readTicket = 0;
+}
+
+bool CatalogParser::parseData(const QByteArray &data, const std::function<bool(const CatalogRow &)> &onRow)
+{
+    JsonReader reader(data);
+    if (!reader.enterObject()) {
+        return false;
+    }
+
+    int itemCount = 0;
+    QString key;
+    while (reader.nextKey(&key)) {
+        if (key != QLatin1String("menuItems") || reader.peek() != JsonReader::Object) {
+            if (!reader.skipValue()) {
+                return false;
+            }
+            continue;
+        }
+        reader.enterObject();
+        while (reader.nextKey(&key)) {
+            if (key != QLatin1String("items") || reader.peek() != JsonReader::Array) {
+                if (!reader.skipValue()) {
+                    return false;
+                }
+                continue;
+            }
+            reader.enterArray();
+            while (reader.nextElement()) {
+                CatalogRow row;
+                if (!parseRow(reader, &itemCount, &row)) {
+                    return false;
+                }
+                if (!onRow(row)) {
+                    return true;
+                }
+            }
+        }
+    }
+    return !reader.hasFailed() && reader.atEnd();
+}
+
+void CatalogParser::onJobDimensions(quint64 ticket, const QVector<CatalogSnapshot::Dimensions> &dimensions,
+                                    bool fromSnapshot)
+{
+    if (ticket == m_ticket) {
+        emit dimensionsLoaded(dimensions, fromSnapshot);
+    }
+}
+
+void CatalogParser::onJobRow(quint64 ticket, const CatalogRow &row)
+{
+    if (ticket == m_ticket) {
+        emit rowParsed(row);
+    }
+}
+
+void CatalogParser::onJobFinished(quint64 ticket, bool ok, const QByteArray &data)
+{
+    if (ticket != m_ticket) {
+        return;
+    }
+    m_ticket = 0;
+    m_cancelled.clear();
+    emit finished(ok, data);
+}
+
+void CatalogParser::onJobSourceRead(quint64 ticket, const QByteArray &data)
+{
+    if (ticket != m_readTicket) {
+        return;
+    }
+    m_readTicket = 0;
+    emit sourceRead(data);
+}
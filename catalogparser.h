@@ -0,0 +1,110 @@
+#ifndef CATALOGPARSER_H
+#define CATALOGPARSER_H
+
+#include "catalogsnapshot.h"
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QMap>
+#include <QMetaType>
+#include <QByteArray>
+#include <QSharedPointer>
+#include <QAtomicInt>
+#include <QThreadPool>
+#include <QRgb>
+#include <functional>
+
+// One poster as the view needs it, already resolved from the menu JSON
+struct CatalogItem {
+    QString title;
+    QString url;                // "//" URLs get https:, items without an image a bundled one
+    QString assetType;
+    QString description;        // shortSynopsis
+    QString programInfo;        // labelProgramInfo
+    QString remainingTimeText;  // template resolved against the item, empty if unknown
+    QRgb placeholderColor = 0;  // dominantColor, transparent if the JSON has none
+    QMap<QString, QString> links;   // upper case event -> href
+    // Where the item's object sits in the catalog file, in bytes
+    int sourceOffset = -1;
+    int sourceLength = 0;
+};
+
+struct CatalogRow {
+    QString classificationId;
+    QString title;
+    QVector<CatalogItem> items;
+};
+
+Q_DECLARE_METATYPE(CatalogRow)
+
+// Parses the hub menu JSON on a worker thread and hands out each row of
+// menuItems.items as soon as its closing bracket is read, so the first
+// swimlane shows and starts loading posters while the rest of the catalog
+// is still being parsed.
+//
+// The parser streams over the raw bytes and never builds a QJsonDocument;
+// only the fields the view shows are turned into strings, everything else
+// is skipped without being decoded. The file is read on the worker too,
+// for resources that includes the decompression.
+//
+// A catalog whose snapshot is current comes from the snapshot instead and
+// its JSON is not even read, otherwise the snapshot is written once the
+// parse completes. Hashing the sources and reading or writing the snapshot
+// also happen on the worker.
+//
+// One parse at a time: starting another or cancel() drops the rows still
+// in flight. The signals and all public methods live on the GUI thread.
+class CatalogParser : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CatalogParser(QObject *parent = nullptr);
+    ~CatalogParser();
+
+    // Reads the UI settings at path, called on the worker
+    typedef std::function<QVector<CatalogSnapshot::Dimensions>(const QString &path)> SettingsReader;
+
+    // Local file or Qt resource paths. The settings are only read if there
+    // is no current snapshot, which holds the dimensions taken from them.
+    void load(const QString &path, const QString &settingsPath, const SettingsReader &readSettings);
+    // Reads the catalog file on the worker, for the JSON the snapshot
+    // leaves out; sourceRead() hands it over
+    void readSource(const QString &path);
+    // Drops the parse and the read still in flight
+    void cancel();
+
+    bool isRunning() const { return m_ticket != 0; }
+
+    // Synchronous parse on the calling thread, the worker runs the same.
+    // onRow returns false to stop early. False if the JSON is malformed,
+    // rows before the error have been handed out by then.
+    static bool parseData(const QByteArray &data, const std::function<bool(const CatalogRow &)> &onRow);
+
+signals:
+    // Before the first row
+    void dimensionsLoaded(const QVector<CatalogSnapshot::Dimensions> &dimensions, bool fromSnapshot);
+    void rowParsed(const CatalogRow &row);
+    // data is the complete file, for callers that need more than the rows;
+    // empty when the rows came from the snapshot or the file could not be
+    // read
+    void finished(bool ok, const QByteArray &data);
+    // Empty if the file could not be read
+    void sourceRead(const QByteArray &data);
+
+private slots:
+    void onJobDimensions(quint64 ticket, const QVector<CatalogSnapshot::Dimensions> &dimensions,
+                         bool fromSnapshot);
+    void onJobRow(quint64 ticket, const CatalogRow &row);
+    void onJobFinished(quint64 ticket, bool ok, const QByteArray &data);
+    void onJobSourceRead(quint64 ticket, const QByteArray &data);
+
+private:
+    QThreadPool m_pool;
+    QSharedPointer<QAtomicInt> m_cancelled;
+    quint64 m_ticket;
+    quint64 m_readTicket;
+    quint64 m_nextTicket;
+};
+
+#endif // CATALOGPARSER_H
@@ -0,0 +1,401 @@
+#include "catalogsnapshot.h"
+#include "catalogparser.h"
+#include <QCryptographicHash>
+#include <QResource>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QDebug>
+#include <cstring>
+
+// Records are plain 32-bit fields so the mapped file can be used in place
+struct SnapshotHeader {
+    quint32 magic;
+    quint32 version;
+    quint8 catalogHash[20];
+    quint8 settingsHash[20];
+    quint32 rowCount;
+    quint32 itemCount;
+    quint32 linkCount;
+    quint32 dimensionCount;
+    quint32 stringCount;
+    quint32 stringDataSize;     // UTF-16 units
+    quint32 reserved[2];
+};
+
+struct SnapshotRow {
+    quint32 title;
+    quint32 classificationId;
+    quint32 firstItem;
+    quint32 itemCount;
+};
+
+struct SnapshotItem {
+    quint32 title;
+    quint32 url;
+    quint32 assetType;
+    quint32 description;
+    quint32 programInfo;
+    quint32 remainingTimeText;
+    quint32 placeholderColor;
+    quint32 firstLink;
+    quint32 linkCount;
+    quint32 sourceOffset;
+    quint32 sourceLength;
+};
+
+struct SnapshotLink {
+    quint32 event;
+    quint32 href;
+};
+
+struct SnapshotDimensions {
+    quint32 category;
+    qint32 rowHeight;
+    qint32 posterHeight;
+    qint32 posterWidth;
+    float itemSpacing;
+};
+
+namespace {
+const quint32 FILE_MAGIC = 0x50534e43;  // "CNSP"
+const quint32 FILE_VERSION = 2;
+const int HASH_SIZE = 20;
+
+static_assert(sizeof(SnapshotHeader) == 80, "SnapshotHeader must stay 80 bytes");
+
+// Offsets of the sections behind the header, all 4 byte aligned
+struct Layout {
+    qint64 rows;
+    qint64 items;
+    qint64 links;
+    qint64 dimensions;
+    qint64 stringOffsets;
+    qint64 stringData;
+    qint64 end;
+};
+
+Layout layoutFor(const SnapshotHeader &header)
+{
+    Layout layout;
+    layout.rows = sizeof(SnapshotHeader);
+    layout.items = layout.rows + qint64(header.rowCount) * sizeof(SnapshotRow);
+    layout.links = layout.items + qint64(header.itemCount) * sizeof(SnapshotItem);
+    layout.dimensions = layout.links + qint64(header.linkCount) * sizeof(SnapshotLink);
+    layout.stringOffsets = layout.dimensions + qint64(header.dimensionCount) * sizeof(SnapshotDimensions);
+    layout.stringData = layout.stringOffsets + (qint64(header.stringCount) + 1) * sizeof(quint32);
+    layout.end = layout.stringData + ((qint64(header.stringDataSize) * 2 + 3) & ~qint64(3));
+    return layout;
+}
+
+// Deduplicates strings while the snapshot is written
+class StringTable
+{
+public:
+    quint32 add(const QString &text)
+    {
+        auto it = m_indices.constFind(text);
+        if (it != m_indices.constEnd()) {
+            return it.value();
+        }
+        const quint32 index = quint32(m_offsets.size());
+        m_offsets.append(quint32(m_data.size()));
+        m_data.append(text);
+        m_indices.insert(text, index);
+        return index;
+    }
+
+    QVector<quint32> offsets() const
+    {
+        QVector<quint32> result = m_offsets;
+        result.append(quint32(m_data.size()));
+        return result;
+    }
+
+    const QString &data() const { return m_data; }
+
+private:
+    QHash<QString, quint32> m_indices;
+    QVector<quint32> m_offsets;
+    QString m_data;
+};
+
+template <typename T>
+void appendRecords(QByteArray *out, const QVector<T> &records)
+{
+    out->append(reinterpret_cast<const char *>(records.constData()), records.size() * int(sizeof(T)));
+}
+}
+
+QByteArray CatalogSnapshot::sourceHash(const QString &path)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (path.startsWith(QLatin1Char(':'))) {
+        QResource resource(path);
+        if (!resource.isValid() || !resource.data()) {
+            return QByteArray();
+        }
+        hash.addData(reinterpret_cast<const char *>(resource.data()), int(resource.size()));
+        hash.addData(resource.isCompressed() ? "z" : "-", 1);
+        return hash.result();
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    if (file.size() == 0) {
+        return hash.result();
+    }
+    if (const uchar *data = file.map(0, file.size())) {
+        hash.addData(reinterpret_cast<const char *>(data), int(file.size()));
+    } else {
+        hash.addData(file.readAll());
+    }
+    return hash.result();
+}
+
+QString CatalogSnapshot::defaultPath(const QString &sourcePath)
+{
+    QString base = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (base.isEmpty()) {
+        base = QDir::tempPath();
+    }
+    const QByteArray name = QCryptographicHash::hash(sourcePath.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return base + QLatin1String("/catalog/") + QString::fromLatin1(name) + QLatin1String(".snapshot");
+}
+
+bool CatalogSnapshot::write(const QString &path, const QByteArray &catalogHash,
+                            const QByteArray &settingsHash, const QVector<CatalogRow> &rows,
+                            const QVector<Dimensions> &dimensions)
+{
+    if (catalogHash.size() != HASH_SIZE || settingsHash.size() != HASH_SIZE) {
+        return false;
+    }
+
+    StringTable strings;
+    QVector<SnapshotRow> rowRecords;
+    QVector<SnapshotItem> itemRecords;
+    QVector<SnapshotLink> linkRecords;
+    QVector<SnapshotDimensions> dimensionRecords;
+
+    for (const CatalogRow &row : rows) {
+        SnapshotRow record = { strings.add(row.title), strings.add(row.classificationId),
+                               quint32(itemRecords.size()), quint32(row.items.size()) };
+        rowRecords.append(record);
+        for (const CatalogItem &item : row.items) {
+            SnapshotItem itemRecord = {
+                strings.add(item.title), strings.add(item.url), strings.add(item.assetType),
+                strings.add(item.description), strings.add(item.programInfo),
+                strings.add(item.remainingTimeText), quint32(item.placeholderColor),
+                quint32(linkRecords.size()), quint32(item.links.size()),
+                quint32(item.sourceOffset), quint32(item.sourceLength)
+            };
+            itemRecords.append(itemRecord);
+            for (auto it = item.links.constBegin(); it != item.links.constEnd(); ++it) {
+                SnapshotLink link = { strings.add(it.key()), strings.add(it.value()) };
+                linkRecords.append(link);
+            }
+        }
+    }
+    for (const Dimensions &dims : dimensions) {
+        SnapshotDimensions record = { strings.add(dims.category), dims.rowHeight, dims.posterHeight,
+                                      dims.posterWidth, float(dims.itemSpacing) };
+        dimensionRecords.append(record);
+    }
+
+    const QVector<quint32> offsets = strings.offsets();
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = FILE_MAGIC;
+    header.version = FILE_VERSION;
+    memcpy(header.catalogHash, catalogHash.constData(), HASH_SIZE);
+    memcpy(header.settingsHash, settingsHash.constData(), HASH_SIZE);
+    header.rowCount = quint32(rowRecords.size());
+    header.itemCount = quint32(itemRecords.size());
+    header.linkCount = quint32(linkRecords.size());
+    header.dimensionCount = quint32(dimensionRecords.size());
+    header.stringCount = quint32(offsets.size() - 1);
+    header.stringDataSize = quint32(strings.data().size());
+
+    QByteArray out;
+    out.reserve(int(layoutFor(header).end));
+    out.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    appendRecords(&out, rowRecords);
+    appendRecords(&out, itemRecords);
+    appendRecords(&out, linkRecords);
+    appendRecords(&out, dimensionRecords);
+    appendRecords(&out, offsets);
+    out.append(reinterpret_cast<const char *>(strings.data().utf16()), strings.data().size() * 2);
+    while (out.size() % 4) {
+        out.append('\0');
+    }
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(out) != out.size() || !file.commit()) {
+        qWarning() << "Failed to write catalog snapshot" << path << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+CatalogSnapshot::CatalogSnapshot()
+    : m_data(nullptr)
+    , m_header(nullptr)
+    , m_rows(nullptr)
+    , m_items(nullptr)
+    , m_links(nullptr)
+    , m_dimensions(nullptr)
+    , m_stringOffsets(nullptr)
+    , m_stringData(nullptr)
+{
+}
+
+CatalogSnapshot::~CatalogSnapshot()
+{
+    close();
+}
+
+bool CatalogSnapshot::open(const QString &path, const QByteArray &catalogHash, const QByteArray &settingsHash)
+{
+    close();
+    if (catalogHash.size() != HASH_SIZE || settingsHash.size() != HASH_SIZE) {
+        return false;
+    }
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly) || m_file.size() < qint64(sizeof(SnapshotHeader))) {
+        m_file.close();
+        return false;
+    }
+    const uchar *data = m_file.map(0, m_file.size());
+    if (!data) {
+        m_file.close();
+        return false;
+    }
+
+    const SnapshotHeader *header = reinterpret_cast<const SnapshotHeader *>(data);
+    const Layout layout = layoutFor(*header);
+    if (header->magic != FILE_MAGIC || header->version != FILE_VERSION
+        || memcmp(header->catalogHash, catalogHash.constData(), HASH_SIZE) != 0
+        || memcmp(header->settingsHash, settingsHash.constData(), HASH_SIZE) != 0
+        || layout.end != m_file.size()) {
+        m_file.unmap(const_cast<uchar *>(data));
+        m_file.close();
+        return false;
+    }
+
+    m_data = data;
+    m_header = header;
+    m_rows = reinterpret_cast<const SnapshotRow *>(data + layout.rows);
+    m_items = reinterpret_cast<const SnapshotItem *>(data + layout.items);
+    m_links = reinterpret_cast<const SnapshotLink *>(data + layout.links);
+    m_dimensions = reinterpret_cast<const SnapshotDimensions *>(data + layout.dimensions);
+    m_stringOffsets = reinterpret_cast<const quint32 *>(data + layout.stringOffsets);
+    m_stringData = reinterpret_cast<const ushort *>(data + layout.stringData);
+
+    // Indices are checked once here so the accessors can trust them
+    const quint32 strings = header->stringCount;
+    bool valid = m_stringOffsets[strings] == header->stringDataSize;
+    for (quint32 i = 0; valid && i < strings; ++i) {
+        valid = m_stringOffsets[i] <= m_stringOffsets[i + 1];
+    }
+    for (quint32 i = 0; valid && i < header->rowCount; ++i) {
+        const SnapshotRow &row = m_rows[i];
+        valid = row.title < strings && row.classificationId < strings
+                && quint64(row.firstItem) + row.itemCount <= header->itemCount;
+    }
+    for (quint32 i = 0; valid && i < header->itemCount; ++i) {
+        const SnapshotItem &item = m_items[i];
+        valid = item.title < strings && item.url < strings && item.assetType < strings
+                && item.description < strings && item.programInfo < strings
+                && item.remainingTimeText < strings
+                && quint64(item.firstLink) + item.linkCount <= header->linkCount;
+    }
+    for (quint32 i = 0; valid && i < header->linkCount; ++i) {
+        valid = m_links[i].event < strings && m_links[i].href < strings;
+    }
+    for (quint32 i = 0; valid && i < header->dimensionCount; ++i) {
+        valid = m_dimensions[i].category < strings;
+    }
+    if (!valid) {
+        qWarning() << "Dropping damaged catalog snapshot" << path;
+        close();
+        QFile::remove(path);
+        return false;
+    }
+    return true;
+}
+
+void CatalogSnapshot::close()
+{
+    if (m_data) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+    }
+    m_file.close();
+    m_data = nullptr;
+    m_header = nullptr;
+    m_rows = nullptr;
+    m_items = nullptr;
+    m_links = nullptr;
+    m_dimensions = nullptr;
+    m_stringOffsets = nullptr;
+    m_stringData = nullptr;
+}
+
+int CatalogSnapshot::rowCount() const
+{
+    return m_header ? int(m_header->rowCount) : 0;
+}
+
+QString CatalogSnapshot::string(quint32 index) const
+{
+    const quint32 begin = m_stringOffsets[index];
+    return QString(reinterpret_cast<const QChar *>(m_stringData + begin), int(m_stringOffsets[index + 1] - begin));
+}
+
+CatalogRow CatalogSnapshot::row(int index) const
+{
+    CatalogRow row;
+    if (index < 0 || index >= rowCount()) {
+        return row;
+    }
+    const SnapshotRow &record = m_rows[index];
+    row.title = string(record.title);
+    row.classificationId = string(record.classificationId);
+    row.items.reserve(int(record.itemCount));
+    for (quint32 i = 0; i < record.itemCount; ++i) {
+        const SnapshotItem &itemRecord = m_items[record.firstItem + i];
+        CatalogItem item;
+        item.title = string(itemRecord.title);
+        item.url = string(itemRecord.url);
+        item.assetType = string(itemRecord.assetType);
+        item.description = string(itemRecord.description);
+        item.programInfo = string(itemRecord.programInfo);
+        item.remainingTimeText = string(itemRecord.remainingTimeText);
+        item.placeholderColor = QRgb(itemRecord.placeholderColor);
+        item.sourceOffset = int(itemRecord.sourceOffset);
+        item.sourceLength = int(itemRecord.sourceLength);
+        for (quint32 l = 0; l < itemRecord.linkCount; ++l) {
+            const SnapshotLink &link = m_links[itemRecord.firstLink + l];
+            item.links.insert(string(link.event), string(link.href));
+        }
+        row.items.append(item);
+    }
+    return row;
+}
+
+QVector<CatalogSnapshot::Dimensions> CatalogSnapshot::dimensions() const
+{
+    QVector<Dimensions> result;
+    for (quint32 i = 0; m_header && i < m_header->dimensionCount; ++i) {
+        const SnapshotDimensions &record = m_dimensions[i];
+        Dimensions dims = { string(record.category), record.rowHeight, record.posterHeight,
+                            record.posterWidth, qreal(record.itemSpacing) };
+        result.append(dims);
+    }
+    return result;
+}
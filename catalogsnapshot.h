@@ -0,0 +1,85 @@
+#ifndef CATALOGSNAPSHOT_H
+#define CATALOGSNAPSHOT_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+#include <QMetaType>
+
+struct CatalogRow;
+
+// File records, defined in catalogsnapshot.cpp
+struct SnapshotHeader;
+struct SnapshotRow;
+struct SnapshotItem;
+struct SnapshotLink;
+struct SnapshotDimensions;
+
+// Binary copy of a parsed catalog, so a start with an unchanged catalog
+// skips reading, decompressing and parsing the JSON; it is only read
+// later if an item's full object is asked for.
+//
+// The file is a flat layout in native byte order: a header, fixed size
+// records for rows, items, links and category dimensions, then a string
+// table. Records refer to strings by index and equal strings are stored
+// once; the table holds UTF-16, so turning an entry into a QString is a
+// copy, not a decode. Items keep their byte range in the catalog JSON.
+// open() maps the file and checks the header against the SHA-1 of the
+// catalog and the UI settings it was made from; any change to either
+// makes the snapshot stale and the JSON is parsed again.
+class CatalogSnapshot
+{
+public:
+    // Layout values taken from uiSettings.json
+    struct Dimensions {
+        QString category;
+        int rowHeight;
+        int posterHeight;
+        int posterWidth;
+        qreal itemSpacing;
+    };
+
+    // SHA-1 of the file as stored; for a compressed resource that is the
+    // compressed data, nothing is inflated to check a snapshot
+    static QByteArray sourceHash(const QString &path);
+    // Where the snapshot of the catalog at sourcePath lives
+    static QString defaultPath(const QString &sourcePath);
+
+    static bool write(const QString &path, const QByteArray &catalogHash,
+                      const QByteArray &settingsHash, const QVector<CatalogRow> &rows,
+                      const QVector<Dimensions> &dimensions);
+
+    CatalogSnapshot();
+    ~CatalogSnapshot();
+
+    // False if there is no snapshot, it is damaged or was made from
+    // different sources
+    bool open(const QString &path, const QByteArray &catalogHash, const QByteArray &settingsHash);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+
+    int rowCount() const;
+    CatalogRow row(int index) const;
+    QVector<Dimensions> dimensions() const;
+
+private:
+    CatalogSnapshot(const CatalogSnapshot&) = delete;
+    CatalogSnapshot& operator=(const CatalogSnapshot&) = delete;
+
+    QString string(quint32 index) const;
+
+    QFile m_file;
+    const uchar *m_data;
+    const SnapshotHeader *m_header;
+    const SnapshotRow *m_rows;
+    const SnapshotItem *m_items;
+    const SnapshotLink *m_links;
+    const SnapshotDimensions *m_dimensions;
+    const quint32 *m_stringOffsets;
+    const ushort *m_stringData;
+};
+
+Q_DECLARE_METATYPE(CatalogSnapshot::Dimensions)
+
+#endif // CATALOGSNAPSHOT_H
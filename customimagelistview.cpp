@@ -18,24 +18,138 @@
 #include <QSGFlatColorMaterial>
 #include <cmath>
 #include <QtMath>
-#include "texturemanager.h"
+#include "swimlanenodes.h"
+#include "textureatlas.h"
+#include "titletexturecache.h"
+#include "glyphtext.h"
+#include "swimlaneanimator.h"
+#include "imagedecoder.h"
+#include "loadscheduler.h"
+#include "posterdiskcache.h"
+#include "fetchservice.h"
+#include "catalogparser.h"
+#include "catalogsnapshot.h"
 #include <QGuiApplication>
 #include <QOpenGLContext>
 #include <QSurfaceFormat>
-#include <QSslConfiguration>
-#include <QSslSocket>
-#include <QNetworkAccessManager>
-#include <QNetworkRequest>
-#include <QNetworkReply>
-#include <QSslSocket>
-#include <QtNetwork/QSslConfiguration>
+#include <QRunnable>
 
 //Q_LOGGING_CATEGORY(ihScheduleModel2, "custom", QtDebugMsg)
 
+namespace {
+// Render thread animation lengths, the scroll matches the old QPropertyAnimation
+const int SCROLL_DURATION = 300;
+const int FOCUS_DURATION = 150;
+// Posters fade in over their placeholder color
+const int CROSSFADE_DURATION = 200;
+const QRgb DEFAULT_PLACEHOLDER_COLOR = qRgb(0x2a, 0x2a, 0x2a);
+const char UI_SETTINGS_PATH[] = ":/data/uiSettings.json";
+
+// Load scheduling. FetchService caps the connections per host for all
+// views together, this keeps the rest of a view's fetches in its own
+// priority queue where they can still be reordered. Decodes beyond the
+// pool size would only wait in the pool where they can no longer be
+// reprioritized, and uploads are spread over frames so a burst of
+// finished decodes does not stall one frame
+const int MAX_NETWORK_LOADS = 6;
+const int MAX_UPLOADS_PER_FRAME = 4;
+// About 200 posters at 1080p, the rest comes back from the disk cache
+const int DEFAULT_IMAGE_CACHE_MB = 32;
+// Items further than this many viewport sizes away are not loaded, and
+// loads still running for them are cancelled
+const qreal LOAD_DISTANCE_SCREENS = 2.0;
+// Textures closer than this are never evicted. Further out than loads
+// reach, so scrolling back and forth does not evict what it reloads.
+const qreal EVICT_DISTANCE_SCREENS = 3.0;
+// Poster textures, a bit over three screens of posters at 1080p
+const int DEFAULT_TEXTURE_BUDGET_MB = 48;
+// How much the distance to the focused poster adds to the priority, so
+// posters around the focus go first within the viewport
+const qreal FOCUS_DISTANCE_WEIGHT = 0.25;
+// Priority of the n-th predicted poster, in the same pixel units, so the
+// next few come right after what is on screen
+const qreal PREFETCH_PRIORITY_STEP = 40;
+
+// Average of an 8x8 grid of samples, close enough to stand in for the
+// poster while it loads
+QRgb averageColor(const QImage &image)
+{
+    const int samples = 8;
+    int r = 0, g = 0, b = 0;
+    for (int y = 0; y < samples; ++y) {
+        for (int x = 0; x < samples; ++x) {
+            const QRgb pixel = qUnpremultiply(image.pixel((2 * x + 1) * image.width() / (2 * samples),
+                                                          (2 * y + 1) * image.height() / (2 * samples)));
+            r += qRed(pixel);
+            g += qGreen(pixel);
+            b += qBlue(pixel);
+        }
+    }
+    const int count = samples * samples;
+    return qRgb(r / count, g / count, b / count);
+}
+
+// Manhattan distance between two rects, 0 when they overlap
+qreal rectDistance(const QRectF &a, const QRectF &b)
+{
+    const qreal dx = qMax<qreal>(0, qMax(b.left() - a.right(), a.left() - b.right()));
+    const qreal dy = qMax<qreal>(0, qMax(b.top() - a.bottom(), a.top() - b.bottom()));
+    return dx + dy;
+}
+
+// Fetched through FetchService, everything else is read from disk
+bool isRemoteImage(const QString &path)
+{
+    return path.startsWith("//") || QUrl(path).scheme().startsWith("http");
+}
+
+// Deletes textures on the render thread, where their GL resources live
+class TextureCleanupJob : public QRunnable
+{
+public:
+    TextureCleanupJob(const QList<QSGTexture*> &textures, TextureAtlas *atlas)
+        : m_textures(textures)
+        , m_atlas(atlas)
+    {
+    }
+
+    void run() override
+    {
+        // Atlas textures release their region, so they go before the atlas
+        qDeleteAll(m_textures);
+        delete m_atlas;
+    }
+
+private:
+    QList<QSGTexture*> m_textures;
+    TextureAtlas *m_atlas;
+};
+
+}
+
 CustomImageListView::CustomImageListView(QQuickItem *parent)
     : QQuickItem(parent)
-    , m_networkManager(new QNetworkAccessManager(this))
-{
+    , m_imageDecoder(new ImageDecoder(this))
+    , m_catalogParser(new CatalogParser(this))
+    , m_loadScheduler(new LoadScheduler(this))
+    , m_decodedImageCache(qint64(DEFAULT_IMAGE_CACHE_MB) * 1024 * 1024)
+    , m_textureResidency(qint64(DEFAULT_TEXTURE_BUDGET_MB) * 1024 * 1024)
+{
+    connect(m_imageDecoder, &ImageDecoder::imageDecoded, this, &CustomImageListView::onImageDecoded);
+    connect(m_imageDecoder, &ImageDecoder::decodeFailed, this, &CustomImageListView::onImageDecodeFailed);
+    connect(m_imageDecoder, &ImageDecoder::cacheMissed, this, &CustomImageListView::onDiskCacheMissed);
+    connect(m_catalogParser, &CatalogParser::dimensionsLoaded, this, &CustomImageListView::onCatalogDimensionsLoaded);
+    connect(m_catalogParser, &CatalogParser::rowParsed, this, &CustomImageListView::onCatalogRowParsed);
+    connect(m_catalogParser, &CatalogParser::finished, this, &CustomImageListView::onCatalogFinished);
+    connect(m_catalogParser, &CatalogParser::sourceRead, this, &CustomImageListView::onCatalogSourceRead);
+
+    // Disk cache reads share the decoder's pool
+    m_loadScheduler->setLimit(LoadScheduler::DiskCache, m_imageDecoder->maxThreadCount());
+    m_loadScheduler->setLimit(LoadScheduler::Network, MAX_NETWORK_LOADS);
+    m_loadScheduler->setLimit(LoadScheduler::Decode, m_imageDecoder->maxThreadCount());
+    m_loadScheduler->setLimit(LoadScheduler::Upload, MAX_UPLOADS_PER_FRAME);
+    connect(m_loadScheduler, &LoadScheduler::ready, this, &CustomImageListView::startLoad);
+
     // Set up rendering flags
     setFlag(ItemHasContents, true);
     setFlag(QQuickItem::ItemIsFocusScope, true);
@@ -48,8 +162,14 @@ CustomImageListView::CustomImageListView(QQuickItem *parent)
     setHeight(300);
     setImplicitHeight(300);
 
-    // Configure network manager
-    setupNetworkManager();
+    // Fetches of every view go through the shared service, each view picks
+    // out its own requests
+    connect(&FetchService::instance(), &FetchService::finished, this, &CustomImageListView::onFetchFinished);
+    connect(&FetchService::instance(), &FetchService::cacheSettingsChanged, this, [this]() {
+        emit httpCacheEnabledChanged();
+        emit httpCacheSizeMBChanged();
+        emit httpCacheDirectoryChanged();
+    });
     
     // Connect to window change signal with proper lambda capture
     connect(this, &QQuickItem::windowChanged, this, [this](QQuickWindow *w) {
@@ -58,14 +178,12 @@ CustomImageListView::CustomImageListView(QQuickItem *parent)
             connect(w, &QQuickWindow::beforeRendering, this, [this, w]() {
                 if (!m_windowReady && w->isSceneGraphInitialized()) {
                     m_windowReady = true;
-                    loadAllImages();
+                    // Render thread, the loads are started on the GUI thread
+                    QMetaObject::invokeMethod(this, "loadAllImages", Qt::QueuedConnection);
                 }
             }, Qt::DirectConnection);
         }
     });
-    
-    // Initialize animation system
-    setupScrollAnimation();
 }
 
 CustomImageListView::~CustomImageListView()
@@ -83,7 +201,7 @@ void CustomImageListView::componentComplete()
         connect(window(), &QQuickWindow::beforeRendering, this, [this]() {
             if (!m_windowReady && window()->isExposed()) {
                 m_windowReady = true;
-                loadAllImages();
+                QMetaObject::invokeMethod(this, "loadAllImages", Qt::QueuedConnection);
             }
         }, Qt::DirectConnection);
     }
@@ -95,6 +213,10 @@ void CustomImageListView::geometryChanged(const QRectF &newGeometry, const QRect
 {
     QQuickItem::geometryChanged(newGeometry, oldGeometry);
 
+    // The visible range depends on our size
+    m_sceneDirty |= SceneLayoutDirty;
+    update();
+
     // Only reload when we have valid dimensions and window
     if (newGeometry.width() > 0 && newGeometry.height() > 0 && window()) {
         // Delay loading slightly to ensure window is ready
@@ -114,135 +236,401 @@ void CustomImageListView::loadAllImages()
         return;
     }
 
-    // Calculate layout and total item count
-    qreal currentY = 0;
-    int totalItems = 0;
+    // Content height and item count come from the layout
+    setImplicitHeight(layout().contentHeight());
+    m_count = layout().itemCount();
+    
+    scheduleLoads();
+}
+
+// Queues every item near the viewport that has no texture yet, updates the
+// priority of queued ones and cancels loads for items that moved too far
+// away. Only the rows and columns near the viewport, the predicted items and
+// the items holding a texture or a load are looked at, never the whole
+// catalog.
+void CustomImageListView::scheduleLoads()
+{
+    m_scheduleLoadsPending = false;
+    if (m_isBeingDestroyed) {
+        return;
+    }
+
+    const QRectF viewport(0, 0, width(), height());
+    const qreal maxDistance = LOAD_DISTANCE_SCREENS * qMax(width(), height());
+    const qreal keepDistance = EVICT_DISTANCE_SCREENS * qMax(width(), height());
+    const QRectF focusRect = itemViewRect(m_currentIndex);
+
+    // Distance to the viewport and the priority a load gets, true for
+    // predicted items
+    auto measure = [&](int index, const QRectF &rect, qreal *distance, qreal *priority) {
+        *distance = rect.isNull() ? keepDistance + 1 : rectDistance(rect, viewport);
+        *priority = *distance;
+        if (!focusRect.isNull() && !rect.isNull()) {
+            *priority += FOCUS_DISTANCE_WEIGHT * rectDistance(rect, focusRect);
+        }
+        auto prefetch = m_prefetchPriorities.constFind(index);
+        if (prefetch == m_prefetchPriorities.constEnd()) {
+            return false;
+        }
+        *priority = qMin(*priority, *prefetch);
+        return true;
+    };
+
+    // Textures are ranked with the same priority their loads get
+    m_textureResidency.resetRanks();
+    for (auto node = m_nodes.constBegin(); node != m_nodes.constEnd(); ++node) {
+        if (node.value().texture) {
+            qreal distance;
+            qreal priority;
+            const bool predicted = measure(node.key(), itemViewRect(node.key()), &distance, &priority);
+            m_textureResidency.rank(node.value().texture, priority, distance <= keepDistance || predicted);
+        }
+    }
+
+    const QList<int> loading = m_inFlightIndexKeys.keys();
+    for (int index : loading) {
+        qreal distance;
+        qreal priority;
+        if (!measure(index, itemViewRect(index), &distance, &priority) && distance > maxDistance) {
+            cancelLoad(index);
+        }
+    }
 
-    // Count total items and calculate height
-    for (const QString &category : m_rowTitles) {
-        int itemsInCategory = 0;
-        for (const ImageData &imgData : m_imageData) {
-            if (imgData.category == category) {
-                itemsInCategory++;
-                totalItems++;
+    auto request = [&](int index, const QRectF &rect) {
+        auto node = m_nodes.constFind(index);
+        if (node != m_nodes.constEnd() && node.value().texture) {
+            return;
+        }
+        qreal distance;
+        qreal priority;
+        const bool predicted = measure(index, rect, &distance, &priority);
+        if (distance > maxDistance && !predicted) {
+            return;
+        }
+        if (m_loadScheduler->isBusy(index)) {
+            // A leader loads for all items sharing its image
+            auto key = m_inFlightKeys.constFind(m_inFlightIndexKeys.value(index));
+            if (key != m_inFlightKeys.constEnd()) {
+                for (qreal followerPriority : key->followers) {
+                    priority = qMin(priority, followerPriority);
+                }
+            }
+            m_loadScheduler->setPriority(index, priority);
+        } else {
+            if (predicted && priority < distance) {
+                ++m_prefetchRequests;
+            }
+            loadImage(index, priority);
+        }
+    };
+
+    // The load band, predicted items are requested after it
+    const LayoutEngine &layout = this->layout();
+    int firstRow = 0;
+    int lastRow = -1;
+    layout.rowRange(m_contentY - maxDistance, m_contentY + height() + maxDistance, &firstRow, &lastRow);
+    for (int row = firstRow; row <= lastRow; ++row) {
+        const QPointF origin(rowOriginX(row), layout.rowTop(row) - m_contentY);
+        int first = 0;
+        int last = -1;
+        layout.columnRange(row, -maxDistance - origin.x(), width() + maxDistance - origin.x(), &first, &last);
+        for (int column = first; column <= last; ++column) {
+            const int index = layout.firstItem(row) + column;
+            if (!m_prefetchPriorities.contains(index)) {
+                request(index, layout.itemRect(index).translated(origin));
             }
         }
-        
-        currentY += m_titleHeight; 
-        currentY += itemsInCategory * (m_itemHeight + m_spacing);
-        currentY += m_rowSpacing;
+    }
+    for (auto it = m_prefetchPriorities.constBegin(); it != m_prefetchPriorities.constEnd(); ++it) {
+        request(it.key(), itemViewRect(it.key()));
     }
 
-    // Update content height and count
-    setImplicitHeight(currentY);
-    m_count = totalItems;
-    
-    // Get list of visible indices first
-    QVector<int> visibleIndices = getVisibleIndices();
-    QVector<int> offscreenIndices;
-    
-    // Add all other indices to the offscreen list
-    for (int i = 0; i < m_count; i++) {
-        if (!visibleIndices.contains(i)) {
-            offscreenIndices.append(i);
+    evictTextures();
+}
+
+// Drops the farthest textures once over budget; the items showing them
+// load again when they come close
+void CustomImageListView::evictTextures()
+{
+    const QList<QSGTexture*> evicted = m_textureResidency.evict();
+    if (evicted.isEmpty()) {
+        return;
+    }
+
+    QSet<QSGTexture*> gone;
+    gone.reserve(evicted.size());
+    for (QSGTexture *texture : evicted) {
+        gone.insert(texture);
+    }
+    for (auto it = m_nodes.begin(); it != m_nodes.end(); ++it) {
+        if (gone.contains(it.value().texture)) {
+            it.value().texture = nullptr;
+            m_dirtyTextures.insert(it.key());
         }
     }
-    
-    qDebug() << "Loading" << visibleIndices.size() << "visible images first, then" 
-             << offscreenIndices.size() << "offscreen images";
-    
-    // First load all visible images
-    for (int index : visibleIndices) {
-        loadImage(index);
+    for (QSGTexture *texture : evicted) {
+        retireTexture(texture);
     }
-    
-    // Then queue off-screen images with a delay to prevent blocking UI
-    for (int i = 0; i < offscreenIndices.size(); i++) {
-        int index = offscreenIndices[i];
-        // Spread out loading of offscreen images to prevent overloading
-        QTimer::singleShot(50 * (i + 1), this, [this, index]() {
-            if (!m_isBeingDestroyed) {
-                loadImage(index);
-            }
-        });
+    emit textureStatsChanged();
+}
+
+// Called after every arrow key, previousIndex is the focus before it
+void CustomImageListView::onNavigated(NavigationPrefetcher::Direction direction, int previousIndex)
+{
+    if (m_currentIndex == previousIndex || m_currentIndex < 0 || m_currentIndex >= m_model.size()) {
+        return;
+    }
+
+    if (m_nodes.contains(m_currentIndex) && m_nodes[m_currentIndex].texture) {
+        ++m_prefetchHits;
+    } else {
+        ++m_prefetchMisses;
     }
+
+    m_prefetcher.recordMove(direction);
+    updatePrefetch();
+    scheduleLoads();
+    emit prefetchStatsChanged();
 }
 
-QVector<int> CustomImageListView::getVisibleIndices()
+// Predicts the posters focus reaches next: further along the row for left
+// and right, the posters around the same column in the next rows for up
+// and down. Lookahead grows with the key repeat rate.
+void CustomImageListView::updatePrefetch()
 {
-    QVector<int> visibleIndices;
-    
-    if (width() <= 0 || height() <= 0) {
-        return visibleIndices;
+    m_prefetchPriorities.clear();
+    m_prefetchLookahead = 0;
+    const LayoutEngine &layout = this->layout();
+    const int row = layout.rowForItem(m_currentIndex);
+    if (row < 0) {
+        return;
     }
-    
-    // Define the viewport boundaries
-    qreal viewportTop = m_contentY;
-    qreal viewportBottom = m_contentY + height();
-    
-    qreal currentY = 0;
-    int currentIndex = 0;
-    
-    // Iterate through categories
-    for (int categoryIndex = 0; categoryIndex < m_rowTitles.size(); ++categoryIndex) {
-        QString categoryName = m_rowTitles[categoryIndex];
-        CategoryDimensions dims = getDimensionsForCategory(categoryName);
-        
-        // Add title height
-        currentY += m_titleHeight + 10; // Same spacing as in updatePaintNode
-        
-        // Skip if entire category is below viewport
-        if (currentY > viewportBottom) {
-            // Skip to next category after counting items in this one
-            for (const ImageData &imgData : m_imageData) {
-                if (imgData.category == categoryName) {
-                    currentIndex++;
-                }
+
+    if (m_prefetcher.isHorizontal()) {
+        // Items of a row are stored next to each other
+        const int step = m_prefetcher.direction() == NavigationPrefetcher::Right ? 1 : -1;
+        const int firstIndex = layout.firstItem(row);
+        const int lastIndex = firstIndex + layout.itemCount(row) - 1;
+        m_prefetchLookahead = m_prefetcher.lookahead();
+        for (int n = 1; n <= m_prefetchLookahead; ++n) {
+            const int index = m_currentIndex + n * step;
+            if (index < firstIndex || index > lastIndex) {
+                break;
             }
-            // Add category height and continue
-            currentY += dims.rowHeight + m_rowSpacing;
-            continue;
+            m_prefetchPriorities.insert(index, n * PREFETCH_PRIORITY_STEP);
         }
-        
-        // Calculate category end position
-        qreal categoryEndY = currentY + dims.rowHeight;
-        
-        // Skip if entire category is above viewport
-        if (categoryEndY < viewportTop) {
-            // Skip this category
-            for (const ImageData &imgData : m_imageData) {
-                if (imgData.category == categoryName) {
-                    currentIndex++;
-                }
+        return;
+    }
+
+    if (m_prefetcher.direction() != NavigationPrefetcher::Up
+        && m_prefetcher.direction() != NavigationPrefetcher::Down) {
+        return;
+    }
+
+    const qreal focusX = rowOriginX(row) + layout.itemRect(m_currentIndex).center().x();
+    const int step = m_prefetcher.direction() == NavigationPrefetcher::Down ? 1 : -1;
+    m_prefetchLookahead = m_prefetcher.rowsAhead();
+    for (int n = 1; n <= m_prefetchLookahead; ++n) {
+        const int targetRow = row + n * step;
+        if (targetRow < 0 || targetRow >= layout.rowCount()) {
+            break;
+        }
+        // Whatever of that row is on screen horizontally once it scrolls
+        // into view, closest to the current column first
+        const qreal originX = rowOriginX(targetRow);
+        int first = 0;
+        int last = -1;
+        layout.columnRange(targetRow, -originX, width() - originX, &first, &last);
+        for (int column = first; column <= last; ++column) {
+            const int index = layout.firstItem(targetRow) + column;
+            const qreal centerX = originX + layout.itemRect(index).center().x();
+            m_prefetchPriorities.insert(index, n * PREFETCH_PRIORITY_STEP
+                                               + FOCUS_DISTANCE_WEIGHT * qAbs(centerX - focusX));
+        }
+    }
+}
+
+void CustomImageListView::resetPrefetchStats()
+{
+    m_prefetchHits = 0;
+    m_prefetchMisses = 0;
+    m_prefetchRequests = 0;
+    emit prefetchStatsChanged();
+}
+
+void CustomImageListView::setImageCacheBudgetMB(int megabytes)
+{
+    megabytes = qMax(0, megabytes);
+    if (megabytes == imageCacheBudgetMB()) {
+        return;
+    }
+    m_decodedImageCache.setBudget(qint64(megabytes) * 1024 * 1024);
+    emit imageCacheBudgetMBChanged();
+    emit imageCacheStatsChanged();
+}
+
+void CustomImageListView::resetImageCacheStats()
+{
+    m_decodedImageCache.resetStats();
+    emit imageCacheStatsChanged();
+}
+
+void CustomImageListView::setTextureBudgetMB(int megabytes)
+{
+    megabytes = qMax(0, megabytes);
+    if (megabytes == textureBudgetMB()) {
+        return;
+    }
+    m_textureResidency.setBudget(qint64(megabytes) * 1024 * 1024);
+    emit textureBudgetMBChanged();
+    handleContentPositionChange();
+}
+
+QRectF CustomImageListView::itemViewRect(int index) const
+{
+    // The layout, moved into item coordinates
+    const LayoutEngine &layout = this->layout();
+    const int row = layout.rowForItem(index);
+    if (row < 0) {
+        return QRectF();
+    }
+    return layout.itemRect(index).translated(rowOriginX(row), layout.rowTop(row) - m_contentY);
+}
+
+void CustomImageListView::startLoad(int index, LoadScheduler::Stage stage)
+{
+    if (m_isBeingDestroyed || index >= m_model.size()) {
+        m_loadScheduler->finished(index, stage);
+        return;
+    }
+
+    switch (stage) {
+    case LoadScheduler::DiskCache:
+        m_imageDecoder->readCache(index, diskCacheKey(index));
+        break;
+    case LoadScheduler::Network: {
+        QString imagePath = m_model.url(index);
+        // Convert // URLs to http://
+        if (imagePath.startsWith("//")) {
+            imagePath.prepend("http:");
+        }
+        loadUrlImage(index, QUrl(imagePath));
+        break;
+    }
+    case LoadScheduler::Decode: {
+        // Local files and resources are read on the worker pool as well
+        const QByteArray data = m_fetchedData.take(index);
+        if (data.isEmpty()) {
+            m_imageDecoder->decodeFile(index, m_model.url(index), posterDecodeSize(index),
+                                       diskCacheKey(index));
+        } else {
+            m_imageDecoder->decodeData(index, data, posterDecodeSize(index), diskCacheKey(index));
+        }
+        break;
+    }
+    case LoadScheduler::Upload:
+        if (m_uploadsThisFrame >= MAX_UPLOADS_PER_FRAME) {
+            // Over this frame's budget, the slot stays taken until the
+            // next sync starts a new one
+            m_deferredUploads.append(index);
+            update();
+            break;
+        }
+        ++m_uploadsThisFrame;
+        processLoadedImage(index, m_decodedImages.take(index));
+        break;
+    default:
+        break;
+    }
+}
+
+void CustomImageListView::cancelLoad(int index)
+{
+    const QString key = m_inFlightIndexKeys.take(index);
+    auto inFlight = m_inFlightKeys.find(key);
+    if (inFlight != m_inFlightKeys.end()) {
+        if (inFlight->leader != index) {
+            // Only waiting, the load goes on for the others
+            inFlight->followers.remove(index);
+            return;
+        }
+        // Hand the load over to the closest item still waiting for it
+        const QHash<int, qreal> followers = inFlight->followers;
+        m_inFlightKeys.erase(inFlight);
+        int next = -1;
+        for (auto it = followers.constBegin(); it != followers.constEnd(); ++it) {
+            if (next < 0 || it.value() < followers.value(next)) {
+                next = it.key();
             }
-            currentY = categoryEndY + m_rowSpacing;
-            continue;
         }
-        
-        // Category is visible (at least partially), check each item
-        qreal xPos = m_startPositionX + 10; // Same as in updatePaintNode
-        qreal categoryX = xPos - getCategoryContentX(categoryName);
-        int itemsInThisCategory = 0;
-        
-        for (int i = 0; i < m_imageData.size(); i++) {
-            if (m_imageData[i].category == categoryName) {
-                // Item is in this category, check if it's visible
-                if (currentY >= viewportTop - dims.posterHeight && 
-                    currentY <= viewportBottom + dims.posterHeight &&
-                    categoryX >= -dims.posterWidth &&
-                    categoryX <= width() + dims.posterWidth) {
-                    
-                    visibleIndices.append(currentIndex);
+        if (next >= 0) {
+            m_inFlightIndexKeys.remove(next);
+            loadImage(next, followers.value(next));
+            for (auto it = followers.constBegin(); it != followers.constEnd(); ++it) {
+                if (it.key() != next) {
+                    m_inFlightIndexKeys.remove(it.key());
+                    loadImage(it.key(), it.value());
                 }
-                
-                categoryX += dims.posterWidth + dims.itemSpacing;
-                currentIndex++;
-                itemsInThisCategory++;
             }
         }
-        
-        // Move to next category
-        currentY = categoryEndY + m_rowSpacing;
+    }
+
+    if (!m_loadScheduler->isBusy(index)) {
+        return;
+    }
+    m_loadScheduler->cancel(index);
+    m_imageDecoder->cancel(index);
+    m_fetchedData.remove(index);
+    m_decodedImages.remove(index);
+    m_deferredUploads.removeAll(index);
+
+    const quint64 fetch = m_fetches.take(index);
+    if (fetch) {
+        m_fetchIndices.remove(fetch);
+        FetchService::instance().cancel(fetch);
+    }
+}
+
+void CustomImageListView::cancelAllLoads()
+{
+    m_inFlightKeys.clear();
+    m_inFlightIndexKeys.clear();
+    m_loadScheduler->clear();
+    m_imageDecoder->cancelAll();
+    m_fetchedData.clear();
+    m_decodedImages.clear();
+    m_deferredUploads.clear();
+
+    for (quint64 fetch : m_fetches) {
+        FetchService::instance().cancel(fetch);
+    }
+    m_fetches.clear();
+    m_fetchIndices.clear();
+}
+
+QVector<int> CustomImageListView::getVisibleIndices()
+{
+    QVector<int> visibleIndices;
+    
+    if (width() <= 0 || height() <= 0) {
+        return visibleIndices;
+    }
+
+    // Rows overlapping the viewport, then the columns of each that are on
+    // screen, give or take a poster
+    const LayoutEngine &layout = this->layout();
+    int firstRow = 0;
+    int lastRow = -1;
+    layout.rowRange(m_contentY, m_contentY + height(), &firstRow, &lastRow);
+    for (int row = firstRow; row <= lastRow; ++row) {
+        const qreal margin = layout.dimensions(row).posterWidth;
+        const qreal originX = rowOriginX(row);
+        int first = 0;
+        int last = -1;
+        layout.columnRange(row, -margin - originX, width() + margin - originX, &first, &last);
+        for (int column = first; column <= last; ++column) {
+            visibleIndices.append(layout.firstItem(row) + column);
+        }
     }
     
     return visibleIndices;
@@ -250,15 +638,22 @@ QVector<int> CustomImageListView::getVisibleIndices()
 
 void CustomImageListView::safeReleaseTextures()
 {
+    // Indices are about to mean different items
+    cancelAllLoads();
+    m_prefetchPriorities.clear();
+    m_prefetcher.reset();
+
     QMutexLocker locker(&m_loadMutex);
     
-    // Only delete nodes, not textures
+    // Textures are retired and deleted on the render thread
     for (auto it = m_nodes.begin(); it != m_nodes.end(); ++it) {
         if (it.value().node) {
             delete it.value().node;
         }
+        releaseItemTexture(it.value().texture);
     }
     m_nodes.clear();
+    m_sceneDirty |= SceneModelDirty;
 }
 
 
@@ -266,9 +661,8 @@ void CustomImageListView::setCount(int count)
 {
     if (m_count != count) {
         m_count = count;
-        for(int i = 0; i < m_count; i++) {
-            loadImage(i);
-        }
+        m_sceneDirty |= SceneModelDirty;
+        scheduleLoads();
         emit countChanged();
         update();
     }
@@ -305,6 +699,8 @@ void CustomImageListView::setRowSpacing(qreal spacing)
 {
     if (m_rowSpacing != spacing) {
         m_rowSpacing = spacing;
+        m_layoutDirty = true;
+        m_sceneDirty |= SceneLayoutDirty;
         emit rowSpacingChanged();
         update();
     }
@@ -390,42 +786,23 @@ QImage CustomImageListView::loadLocalImage(int index) const
     return fallback;
 }
 
-QSGGeometryNode* CustomImageListView::createTexturedRect(const QRectF &rect, QSGTexture *texture, bool isFocused)
+QSGGeometryNode* CustomImageListView::createTexturedRect(const QRectF &rect, QSGTexture *texture)
 {
-    // Calculate scale factor for focus effect
-    const float scaleFactor = isFocused ? 1.1f : 1.0f;  // 10% larger when focused
-    
-    // Calculate scaled dimensions and center position
-    QRectF scaledRect = rect;
-    if (isFocused) {
-        qreal widthDiff = rect.width() * (scaleFactor - 1.0f);
-        qreal heightDiff = rect.height() * (scaleFactor - 1.0f);
-        scaledRect = QRectF(
-            rect.x() - widthDiff / 2,
-            rect.y() - heightDiff / 2,
-            rect.width() * scaleFactor,
-            rect.height() * scaleFactor
-        );
-    }
-
-    // Create geometry for a textured rectangle
+    // Focus zoom lives in PosterMaterial now, this is only used for titles
     QSGGeometry *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_TexturedPoint2D(), 4);
     geometry->setDrawingMode(GL_TRIANGLE_STRIP);
 
-    QSGGeometry::TexturedPoint2D *vertices = geometry->vertexDataAsTexturedPoint2D();
-    
-    // Set vertex positions using scaled rect
-    vertices[0].set(scaledRect.left(), scaledRect.top(), 0.0f, 0.0f);
-    vertices[1].set(scaledRect.right(), scaledRect.top(), 1.0f, 0.0f);
-    vertices[2].set(scaledRect.left(), scaledRect.bottom(), 0.0f, 1.0f);
-    vertices[3].set(scaledRect.right(), scaledRect.bottom(), 1.0f, 1.0f);
+    // Atlas textures only cover a sub rect
+    setTexturedRectGeometry(geometry, rect, texture->normalizedTextureSubRect());
 
     QSGGeometryNode *node = new QSGGeometryNode;
     node->setGeometry(geometry);
     node->setFlag(QSGNode::OwnsGeometry);
 
-    QSGOpaqueTextureMaterial *material = new QSGOpaqueTextureMaterial;
+    // Titles are premultiplied glyphs on transparent pixels, they need blending
+    QSGTextureMaterial *material = new QSGTextureMaterial;
     material->setTexture(texture);
+    material->setFlag(QSGMaterial::Blending, texture->hasAlphaChannel());
     
     node->setMaterial(material);
     node->setFlag(QSGNode::OwnsMaterial);
@@ -453,53 +830,75 @@ bool CustomImageListView::isReadyForTextures() const
     return true;
 }
 
-void CustomImageListView::loadImage(int index)
+// Queues the item in the first stage it needs, LoadScheduler starts it
+// through startLoad() once it is among the closest ones
+void CustomImageListView::loadImage(int index, qreal priority)
 {
-    if (m_isBeingDestroyed || !ensureValidWindow() || index >= m_imageData.size()) {
+    if (m_isBeingDestroyed || !ensureValidWindow() || index >= m_model.size()) {
         return;
     }
 
     QMutexLocker locker(&m_loadMutex);
     
+    // loadAllImages() runs again once the window is ready
     if (!isReadyForTextures()) {
-        QTimer::singleShot(100, this, [this, index]() {
-            loadImage(index);
-        });
         return;
     }
 
-    // Prevent duplicate texture creation
-    if (m_nodes.contains(index) && m_nodes[index].texture) {
+    // Prevent duplicate texture creation and duplicate loads
+    if ((m_nodes.contains(index) && m_nodes[index].texture) || m_loadScheduler->isBusy(index)) {
         return;
     }
 
-    m_isLoading = true;
+    // Another item already shows or loads the same image
+    const QString key = loadKey(index);
+    if (QSGTexture *texture = m_textureResidency.find(key)) {
+        setItemTexture(index, texture);
+        return;
+    }
+    auto inFlight = m_inFlightKeys.find(key);
+    if (inFlight != m_inFlightKeys.end()) {
+        inFlight->followers.insert(index, priority);
+        m_inFlightIndexKeys.insert(index, key);
+        if (priority < m_loadScheduler->priority(inFlight->leader)) {
+            m_loadScheduler->setPriority(inFlight->leader, priority);
+        }
+        return;
+    }
 
-    // Load from URL
-    const ImageData &imgData = m_imageData[index];
-    QString imagePath = imgData.url;
+    // Local files, resources and network URLs, anything else has no image
+    const QString &imagePath = m_model.url(index);
+    if (!QFile::exists(imagePath) && !isRemoteImage(imagePath)) {
+        createFallbackTexture(index);
+        return;
+    }
+    m_inFlightKeys.insert(key, InFlightKey{ index, QHash<int, qreal>() });
+    m_inFlightIndexKeys.insert(index, key);
 
-    // First try to load as local resource
-    QImage image = loadLocalImageFromPath(imagePath);
-    if (!image.isNull()) {
-        processLoadedImage(index, image);
-        m_isLoading = false;
+    // Decoded earlier in this session
+    const QImage cached = m_decodedImageCache.find(key);
+    emit imageCacheStatsChanged();
+    if (!cached.isNull()) {
+        m_decodedImages.insert(index, cached);
+        m_loadScheduler->enqueue(index, LoadScheduler::Upload, priority);
         return;
     }
 
-    // If not a local resource, try as network URL
-    QUrl url(imagePath);
-    if (url.scheme().startsWith("http") || imagePath.startsWith("//")) {
-        // Convert // URLs to http://
-        if (imagePath.startsWith("//")) {
-            url = QUrl("http:" + imagePath);
-        }
-        loadUrlImage(index, url);
-    } else {
-        createFallbackTexture(index);
+    // Maybe scaled on an earlier run, the worker pool maps it from the disk
+    // cache and uploads it as is
+    m_loadScheduler->enqueue(index, LoadScheduler::DiskCache, priority);
+}
+
+void CustomImageListView::onDiskCacheMissed(int index)
+{
+    m_loadScheduler->finished(index, LoadScheduler::DiskCache);
+    if (m_isBeingDestroyed || index >= m_model.size()) {
+        return;
     }
 
-    m_isLoading = false;
+    // Local files and resources only need decoding
+    m_loadScheduler->enqueue(index, isRemoteImage(m_model.url(index)) ? LoadScheduler::Network
+                                                                      : LoadScheduler::Decode);
 }
 
 bool CustomImageListView::ensureValidWindow() const
@@ -521,41 +920,21 @@ void CustomImageListView::createFallbackTexture(int index)
     painter.end();
     
     if (window()) {
-        QSGTexture *texture = window()->createTextureFromImage(fallback);
+        QSGTexture *texture = createPosterTexture(fallback);
         if (texture) {
-            TexturedNode node;
-            node.texture = texture;
-            node.node = nullptr;
-            m_nodes[index] = node;
-            update();
+            setItemTexture(index, texture);
             qDebug() << "Created fallback texture for index:" << index;
         }
     }
-}
 
-QImage CustomImageListView::loadLocalImageFromPath(const QString &path) const
-{
-    QFile file(path);
-    if (file.open(QIODevice::ReadOnly)) {
-        QByteArray imageData = file.readAll();
-        QImage image;
-        if (image.loadFromData(imageData)) {
-            qDebug() << "Successfully loaded image from:" << path;
-            qDebug() << "Image size:" << image.size();
-            file.close();
-            return image;
-        }
-        file.close();
-    }
-
-    qDebug() << "Failed to load image from:" << path;
-    return QImage();
+    // The items waiting for the same image failed as well
+    finishInFlightKey(index, nullptr);
 }
 
-// Update loadUrlImage method to better handle HTTP requests
 void CustomImageListView::loadUrlImage(int index, const QUrl &url)
 {
-    if (!m_networkManager || m_isDestroying) {
+    if (m_isDestroying) {
+        m_loadScheduler->finished(index, LoadScheduler::Network);
         return;
     }
 
@@ -565,120 +944,157 @@ void CustomImageListView::loadUrlImage(int index, const QUrl &url)
         finalUrl = QUrl("https:" + url.toString());
     }
 
-    // For HTTP URLs
-    if (finalUrl.scheme() == "http") {
+    if (finalUrl.scheme() == "http" || finalUrl.scheme() == "https") {
         qDebug() << "Loading image" << index << "from URL:" << finalUrl.toString();
-        
-        // Create network request
-        QNetworkRequest request(finalUrl);
-        
-        // Essential headers for Qt 5.6
-        request.setRawHeader("User-Agent", "Mozilla/5.0 (compatible; Qt/5.6)");
-        request.setRawHeader("Accept", "image/webp,image/apng,image/*,*/*;q=0.8");
-        request.setRawHeader("Connection", "keep-alive");
-        
-        // Enable redirect following
-        request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
-        request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
-        
-        QNetworkReply* oldReply = nullptr;
-        
-        // Only lock mutex for the map operations
-        {
-            QMutexLocker locker(&m_networkMutex);
-            
-            // Store old reply for later deletion outside the lock
-            if (m_pendingRequests.contains(index)) {
-                oldReply = m_pendingRequests.take(index);
-            }
-        }
-        
-        // Cancel old request outside the mutex lock
-        if (oldReply) {
-            oldReply->disconnect(); // Prevent callbacks
-            oldReply->abort();
-            oldReply->deleteLater();
-        }
-      
-      
-    #ifndef QT_NO_SSL
-        if (finalUrl.scheme() == "https") {
-            QSslConfiguration sslConfig = request.sslConfiguration();
-            sslConfig.setPeerVerifyMode(QSslSocket::VerifyNone);
-            sslConfig.setProtocol(QSsl::TlsV1_0);
-            request.setSslConfiguration(sslConfig);
-        }
-    #endif
-          
-        // Create network reply
-        QNetworkReply *reply = m_networkManager->get(request);
-        
-        // Store the reply in our map with minimal lock time
-        {
-            QMutexLocker locker(&m_networkMutex);
-            m_pendingRequests[index] = reply;
+
+        // A running fetch of the item is replaced
+        const quint64 oldFetch = m_fetches.take(index);
+        if (oldFetch) {
+            m_fetchIndices.remove(oldFetch);
+            FetchService::instance().cancel(oldFetch);
         }
-        
-        // Connect signals with Qt 5.6 compatible syntax
-        connect(reply, SIGNAL(finished()), this, SLOT(onNetworkReplyFinished()));
-        connect(reply, SIGNAL(error(QNetworkReply::NetworkError)), 
-                this, SLOT(onNetworkError(QNetworkReply::NetworkError)));
-        connect(reply, SIGNAL(sslErrors(QList<QSslError>)), 
-                reply, SLOT(ignoreSslErrors()));
-        
-        // Add longer timeout for slower connections
-        QTimer::singleShot(30000, reply, SLOT(abort()));
+
+        const quint64 fetch = FetchService::instance().get(finalUrl);
+        m_fetches.insert(index, fetch);
+        m_fetchIndices.insert(fetch, index);
     } else {
         qWarning() << "Unsupported URL scheme:" << finalUrl.scheme();
+        m_loadScheduler->finished(index, LoadScheduler::Network);
         createFallbackTexture(index);
-
     }
+}
 
-    // Create and store network reply
-    QNetworkReply *reply = m_networkManager->get(request);
-    m_pendingRequests[index] = reply;
+void CustomImageListView::onFetchFinished(quint64 id, const QByteArray &data, bool fromCache)
+{
+    auto it = m_fetchIndices.find(id);
+    if (it == m_fetchIndices.end()) {
+        // Another view's request
+        return;
+    }
+    const int index = it.value();
+    m_fetchIndices.erase(it);
+    m_fetches.remove(index);
+    m_loadScheduler->finished(index, LoadScheduler::Network);
 
-    // Connect signals with Qt 5.6 compatible syntax
-    connect(reply, SIGNAL(finished()), this, SLOT(onNetworkReplyFinished()));
-    connect(reply, SIGNAL(error(QNetworkReply::NetworkError)), 
-            this, SLOT(onNetworkError(QNetworkReply::NetworkError)));
-    connect(reply, SIGNAL(sslErrors(QList<QSslError>)), 
-            reply, SLOT(ignoreSslErrors()));
+    if (FetchService::instance().isCacheEnabled()) {
+        if (fromCache) {
+            ++m_httpCacheHits;
+        } else {
+            ++m_httpCacheMisses;
+        }
+        emit httpCacheStatsChanged();
+    }
 
-    // Add timeout
-    QTimer::singleShot(30000, reply, SLOT(abort()));
+    if (!data.isEmpty()) {
+        // Decoded on the worker pool once a decode slot is free
+        m_fetchedData.insert(index, data);
+        m_loadScheduler->enqueue(index, LoadScheduler::Decode);
+    } else {
+        createFallbackTexture(index);
+    }
 }
 
+// The image comes from ImageDecoder already scaled and in RGBA8888, only
+// the upload into the atlas is left for the GUI thread
 void CustomImageListView::processLoadedImage(int index, const QImage &image)
 {
+    if (m_isBeingDestroyed || index >= m_model.size()) {
+        return;
+    }
+
+    QSGTexture *texture = nullptr;
     if (!image.isNull() && window()) {
-        // Convert image to optimal format for textures
-        QImage optimizedImage = image.convertToFormat(QImage::Format_RGBA8888);
-        
-        // Scale maintaining aspect ratio
-        QImage scaledImage = optimizedImage.scaled(m_itemWidth, m_itemHeight,
-                                                 Qt::KeepAspectRatio,
-                                                 Qt::SmoothTransformation);
-        
-        // Create texture with proper flag (corrected syntax)
-        QSGTexture *texture = window()->createTextureFromImage(
-            scaledImage,
-            QQuickWindow::TextureHasAlphaChannel
-        );
+        // Pack into the poster atlas so rows batch into a few draw calls
+        texture = createPosterTexture(image);
 
         if (texture) {
-            // Update the node map
-            TexturedNode node;
-            node.texture = texture;
-            node.node = nullptr;
-            m_nodes[index] = node;
+            if (!m_placeholderColors.contains(m_model.url(index))) {
+                m_placeholderColors.insert(m_model.url(index), averageColor(image));
+            }
+            const QString key = m_inFlightIndexKeys.value(index, loadKey(index));
+            m_textureResidency.insert(key, texture, qint64(image.bytesPerLine()) * image.height());
+            setItemTexture(index, texture);
+            finishInFlightKey(index, texture);
+
+            // Ranked and evicted with the next reprioritization
+            if (m_textureResidency.isOverBudget()) {
+                handleContentPositionChange();
+            }
+            emit textureStatsChanged();
             
             qDebug() << "Created texture for image" << index 
-                     << "size:" << scaledImage.size();
-            
-            update(); // Request new frame
+                     << "size:" << image.size();
         }
     }
+
+    if (!texture) {
+        // Never leave the items sharing this image waiting
+        finishInFlightKey(index, nullptr);
+    }
+    m_loadScheduler->finished(index, LoadScheduler::Upload);
+}
+
+void CustomImageListView::uploadDeferred()
+{
+    while (!m_deferredUploads.isEmpty() && m_uploadsThisFrame < MAX_UPLOADS_PER_FRAME) {
+        const int index = m_deferredUploads.takeFirst();
+        ++m_uploadsThisFrame;
+        processLoadedImage(index, m_decodedImages.take(index));
+    }
+}
+
+QSize CustomImageListView::posterDecodeSize(int index) const
+{
+    // Textures are drawn at poster size, decoding any larger only costs
+    // memory and decode time
+    const int row = layout().rowForItem(index);
+    if (row < 0) {
+        return QSize();
+    }
+    const LayoutEngine::RowDimensions &dims = layout().dimensions(row);
+    const qreal dpr = window() ? window()->devicePixelRatio() : 1.0;
+    return QSize(qCeil(dims.posterWidth * dpr), qCeil(dims.posterHeight * dpr));
+}
+
+QRgb CustomImageListView::placeholderColor(int index) const
+{
+    if (index < 0 || index >= m_model.size()) {
+        return DEFAULT_PLACEHOLDER_COLOR;
+    }
+    if (qAlpha(m_model.placeholderColor(index))) {
+        return m_model.placeholderColor(index);
+    }
+    return m_placeholderColors.value(m_model.url(index), DEFAULT_PLACEHOLDER_COLOR);
+}
+
+QString CustomImageListView::diskCacheKey(int index) const
+{
+    return PosterDiskCache::key(m_model.url(index), posterDecodeSize(index),
+                                QImage::Format_RGBA8888_Premultiplied);
+}
+
+void CustomImageListView::onImageDecoded(int index, const QImage &image, bool fromDiskCache)
+{
+    m_loadScheduler->finished(index, fromDiskCache ? LoadScheduler::DiskCache : LoadScheduler::Decode);
+    if (m_isBeingDestroyed || index >= m_model.size()) {
+        return;
+    }
+    m_decodedImages.insert(index, image);
+    m_loadScheduler->enqueue(index, LoadScheduler::Upload);
+
+    // Disk cache hits are not kept, they are mapped and cheap to find again
+    if (!fromDiskCache) {
+        m_decodedImageCache.insert(m_inFlightIndexKeys.value(index, loadKey(index)), image);
+        emit imageCacheStatsChanged();
+    }
+}
+
+void CustomImageListView::onImageDecodeFailed(int index)
+{
+    m_loadScheduler->finished(index, LoadScheduler::Decode);
+    if (!m_isBeingDestroyed && index < m_model.size()) {
+        createFallbackTexture(index);
+    }
 }
 
 void CustomImageListView::setImageTitles(const QStringList &titles)
@@ -694,295 +1110,454 @@ void CustomImageListView::setRowTitles(const QStringList &titles)
 {
     if (m_rowTitles != titles) {
         m_rowTitles = titles;
+        m_layoutDirty = true;
+        m_sceneDirty |= SceneModelDirty;
         emit rowTitlesChanged();
         update();
     }
 }
 
-QSGGeometryNode* CustomImageListView::createOptimizedTextNode(const QString &text, const QRectF &rect)
+QSGGeometryNode* CustomImageListView::createRowTitleNode(const QString &text, const QRectF &rect, QSGTexture **textureOut)
 {
     if (!window()) {
         return nullptr;
     }
 
-    // Create new texture for text (don't use caching for now)
-    int width = qMax(1, static_cast<int>(std::ceil(rect.width())));
-    int height = qMax(1, static_cast<int>(std::ceil(rect.height())));
-    
-    QImage textImage(width, height, QImage::Format_ARGB32_Premultiplied);
-    if (textImage.isNull()) {
+    // Rasterized once per (text, font, color, DPR) and shared by all views;
+    // the caller hands the texture back to the cache when the node goes away
+    static const QFont titleFont("Roboto", 20, QFont::Bold);
+    static const QColor titleColor("#ebebeb");
+    QSizeF titleSize;
+    QSGTexture *texture = TitleTextureCache::instance().acquire(
+        window(), text, titleFont, titleColor,
+        qMax(1, static_cast<int>(std::ceil(rect.height()))), &titleSize);
+
+    if (!texture) {
         return nullptr;
     }
-    
-    textImage.fill(QColor(0, 0, 0, 0));
-    
-    QPainter painter;
-    if (!painter.begin(&textImage)) {
-        return nullptr;
+
+    if (textureOut) {
+        *textureOut = texture;
     }
 
-    static const QFont itemFont("Arial", 12);
-    painter.setFont(itemFont);
-    painter.setPen(Qt::white);
-    painter.setRenderHints(QPainter::TextAntialiasing | QPainter::SmoothPixmapTransform);
-    painter.drawText(textImage.rect(), Qt::AlignCenter, text);
-    painter.end();
-    
-    QSGTexture *texture = window()->createTextureFromImage(
-        textImage,
-        QQuickWindow::TextureHasAlphaChannel
-    );
-    
-    return texture ? createTexturedRect(rect, texture) : nullptr;
+    // Create adjusted rect with 8 pixels left offset
+    QRectF adjustedRect(rect.x() - 8, rect.y(), titleSize.width(), titleSize.height());
+    return createTexturedRect(adjustedRect, texture);
 }
 
-QSGGeometryNode* CustomImageListView::createRowTitleNode(const QString &text, const QRectF &rect)
+// Retained scene graph: row and poster nodes are created once and only the
+// parts that changed since the last frame are updated and marked dirty.
+// Posters only exist for items inside the viewport plus cacheBuffer and are
+// recycled through a pool as rows scroll.
+QSGNode* CustomImageListView::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *)
 {
-    if (!window()) {
+    if (m_isBeingDestroyed || !window() || !window()->isExposed()) {
+        delete oldNode;
+        // The tree is gone, build it again from scratch next time
+        m_sceneDirty |= SceneModelDirty;
         return nullptr;
     }
 
-    // Calculate title width based on text content
-    QFont titleFont("Roboto", 20, QFont::Bold);  // Using Roboto font, size 20, bold
-    QFontMetrics fm(titleFont);
-    int textWidth = fm.width(text) + 20;  // Add 20px padding
-    int width = qMax(textWidth, static_cast<int>(std::ceil(rect.width())));
-    int height = qMax(1, static_cast<int>(std::ceil(rect.height())));
+    SwimlaneRootNode *rootNode = static_cast<SwimlaneRootNode*>(oldNode);
+    if (!rootNode) {
+        rootNode = new SwimlaneRootNode;
+        rootNode->setAnimator(new SwimlaneAnimator(window(), rootNode));
+        m_sceneDirty |= SceneModelDirty;
+    }
+    SwimlaneAnimator *animator = rootNode->animator();
 
-    QImage textImage(width, height, QImage::Format_ARGB32_Premultiplied);
-    if (textImage.isNull()) {
-        return nullptr;
+    // The GUI thread is blocked during the sync, a new frame's upload
+    // budget starts here and the uploads held back are posted to it
+    m_uploadsThisFrame = 0;
+    if (!m_deferredUploads.isEmpty()) {
+        QMetaObject::invokeMethod(this, "uploadDeferred", Qt::QueuedConnection);
     }
 
-    textImage.fill(QColor(0, 0, 0, 0));
+    // Rows from here on are new this frame and get laid out below
+    int firstNewRow = rootNode->rows().size();
+    if (m_sceneDirty & SceneModelDirty) {
+        rebuildRowNodes(rootNode);
+    } else if (m_sceneDirty & SceneRowsAppended) {
+        appendRowNodes(rootNode);
+    }
 
-    QPainter painter;
-    if (!painter.begin(&textImage)) {
-        return nullptr;
+    // Compact sparse atlas pages a little each frame; moved textures need
+    // their texture coordinates refreshed
+    if (m_posterAtlas) {
+        m_posterAtlas->defragment();
+        if (m_posterAtlas->generation() != m_atlasGeneration) {
+            m_atlasGeneration = m_posterAtlas->generation();
+            rootNode->refreshTextures();
+        }
     }
 
-    // Configure text rendering with focus properties
-    painter.setFont(titleFont);
-    painter.setPen(QColor("#ebebeb"));  // Set focus color
-    painter.setRenderHints(QPainter::TextAntialiasing | QPainter::SmoothPixmapTransform);
+    const QVector<SwimlaneRowNode*> &rows = rootNode->rows();
 
-    // Draw text with left alignment and vertical centering
-    int yPos = (height + fm.ascent() - fm.descent()) / 2;
-    painter.drawText(10, yPos, text);
-    
-    painter.end();
+    // Row tops are content coordinates, contentY is the root's content
+    // transform
+    const LayoutEngine &layout = this->layout();
 
-    // Create texture
-    QSGTexture *texture = window()->createTextureFromImage(
-        textImage,
-        QQuickWindow::TextureHasAlphaChannel
-    );
+    // Vertical scrolling is one matrix, animated on the render thread when
+    // it comes from key navigation
+    const bool layoutDirty = m_sceneDirty & (SceneModelDirty | SceneLayoutDirty);
+    const bool scrollDirty = m_sceneDirty & SceneScrollDirty;
+    if (m_animateContentY) {
+        animator->scrollContent(m_contentY, SCROLL_DURATION);
+    } else if (scrollDirty) {
+        animator->scrollContent(m_contentY, 0);
+    } else {
+        animator->retargetContent(m_contentY);
+    }
+    animator->contentRange(&m_syncContentMinY, &m_syncContentMaxY);
+
+    // Re-virtualize everything on a layout change. Vertical and horizontal
+    // scrolling only move matrices, plus posters entering the range.
+    if (layoutDirty || scrollDirty || !m_dirtyRows.isEmpty() || !m_animatedRows.isEmpty()
+            || firstNewRow < rows.size()) {
+        for (SwimlaneRowNode *rowNode : rows) {
+            const int row = rowNode->row();
+            const bool relayout = layoutDirty || row >= firstNewRow;
+            if (relayout || scrollDirty || m_dirtyRows.contains(row) || m_animatedRows.contains(row)) {
+                updateRowNode(rowNode, layout.rowTop(row), relayout, animator);
+            }
+        }
+    }
 
-    if (!texture) {
-        return nullptr;
+    // Attach textures that arrived since the last frame, but only for
+    // items that currently have a node. A poster that was showing its
+    // placeholder crossfades to the image.
+    for (int index : m_dirtyTextures) {
+        SwimlaneRowNode *rowNode = rootNode->rowForIndex(index);
+        if (!rowNode || !rowNode->isMaterialized(index)) {
+            continue;
+        }
+        auto it = m_nodes.constFind(index);
+        QSGTexture *texture = it != m_nodes.constEnd() ? it.value().texture : nullptr;
+
+        PosterNode *poster = rowNode->poster(index);
+        const bool created = !poster;
+        if (created) {
+            poster = rowNode->ensurePoster(index);
+            poster->setPlaceholderColor(placeholderColor(index));
+            poster->setRect(posterRect(index));
+            poster->setFocused(index == m_paintedFocusIndex);
+        }
+        const bool hadTexture = poster->texture();
+        poster->setTexture(texture);
+        if (!texture) {
+            // Evicted, the placeholder shows until it is loaded again
+            animator->conceal(index);
+        } else if (created) {
+            poster->setReveal(1);
+        } else if (!hadTexture) {
+            animator->reveal(index, CROSSFADE_DURATION);
+        }
     }
 
-    // Create adjusted rect with 8 pixels left offset
-    QRectF adjustedRect(rect.x() - 8, rect.y(), textWidth, rect.height());
-    return createTexturedRect(adjustedRect, texture);
+    // Focus only touches the previously and the newly focused poster, the
+    // zoom between them is animated on the render thread. The text of their
+    // rows moves with the zoom.
+    if (m_paintedFocusIndex != m_currentIndex) {
+        SwimlaneRowNode *oldRow = rootNode->rowForIndex(m_paintedFocusIndex);
+        SwimlaneRowNode *newRow = rootNode->rowForIndex(m_currentIndex);
+        animator->focus(m_paintedFocusIndex, m_currentIndex,
+                        m_paintedFocusIndex < 0 ? 0 : FOCUS_DURATION);
+        m_paintedFocusIndex = m_currentIndex;
+
+        if (oldRow) {
+            updateRowText(oldRow);
+        }
+        if (newRow && newRow != oldRow) {
+            updateRowText(newRow);
+        }
+    }
+
+    m_sceneDirty = 0;
+    m_dirtyRows.clear();
+    m_dirtyTextures.clear();
+    m_animatedRows.clear();
+    m_animateContentY = false;
+
+    // No node references the retired textures anymore
+    qDeleteAll(m_retiredTextures);
+    m_retiredTextures.clear();
+
+    // Publish the node count, we are on the render thread here
+    int nodeCount = rootNode->nodeCount();
+    if (m_nodeCount.fetchAndStoreRelaxed(nodeCount) != nodeCount) {
+        QMetaObject::invokeMethod(this, "nodeCountChanged", Qt::QueuedConnection);
+    }
+
+    return rootNode;
 }
 
-// Fix the return type from void to QSGNode*
-QSGNode* CustomImageListView::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *)
+QSGTexture *CustomImageListView::createPosterTexture(const QImage &image)
 {
-    if (m_isBeingDestroyed || !window() || !window()->isExposed()) {
-        delete oldNode;
-        return nullptr;
+    if (!m_posterAtlas) {
+        m_posterAtlas = new TextureAtlas;
     }
-    
-    QSGNode *parentNode = oldNode ? oldNode : new QSGNode;
-    
-    // Clear old nodes safely
-    while (parentNode->childCount() > 0) {
-        QSGNode *node = parentNode->firstChild();
-        if (node) {
-            parentNode->removeChildNode(node);
-            delete node;
-        }
+    if (QSGTexture *texture = m_posterAtlas->insert(image)) {
+        return texture;
     }
-    
-    qreal currentY = -m_contentY;
-    int currentImageIndex = 0;
-    
-    // Create category containers
-    for (int categoryIndex = 0; categoryIndex < m_rowTitles.size(); ++categoryIndex) {
-        QString categoryName = m_rowTitles[categoryIndex];
-        
-        // Get dimensions for this category
-        CategoryDimensions dims = getDimensionsForCategory(categoryName);
-        
-        // Calculate title width based on category name
-        static const QFont titleFont("Arial", 24, QFont::Bold);
-        QFontMetrics fm(titleFont);
-        int titleWidth = fm.width(categoryName) + 20;  // Add 20px padding
-        
-        // Add startPositionX to title position
-        QRectF titleRect(m_startPositionX + 10, currentY, titleWidth, m_titleHeight);  // Changed from 5 to 10
-        QSGGeometryNode *titleNode = createRowTitleNode(categoryName, titleRect);
-        if (titleNode) {
-            parentNode->appendChildNode(titleNode);
-        }
-        currentY += m_titleHeight + 10; // Changed from 5 to 10 for more spacing after title
-        
-        // Calculate items in this category
-        QVector<ImageData> categoryItems;
-        for (const ImageData &imgData : m_imageData) {
-            if (imgData.category == categoryName) {
-                categoryItems.append(imgData);
-            }
-        }
 
-        // Add items using category-specific dimensions with 10-pixel offset (increased from 5)
-        qreal xPos = m_startPositionX + 10 - getCategoryContentX(categoryName);  // Changed from 5 to 10
-        for (const ImageData &imgData : categoryItems) {
-            if (currentImageIndex < m_count) {
-                QRectF rect(xPos, currentY, dims.posterWidth, dims.posterHeight);
-                
-                // Create item container
-                QSGNode* itemContainer = new QSGNode;
-
-                // Add image with focus effect
-                if (m_nodes.contains(currentImageIndex) && m_nodes[currentImageIndex].texture) {
-                    bool isFocused = (currentImageIndex == m_currentIndex);
-                    QSGGeometryNode *imageNode = createTexturedRect(
-                        rect, 
-                        m_nodes[currentImageIndex].texture,
-                        isFocused
-                    );
-                    if (imageNode) {
-                        itemContainer->appendChildNode(imageNode);
-                        m_nodes[currentImageIndex].node = imageNode;
-                    }
-                }
+    // Atlas full or image too large, fall back to a standalone texture
+    return window() ? window()->createTextureFromImage(image, QQuickWindow::TextureHasAlphaChannel)
+                    : nullptr;
+}
 
-                // Add selection/focus effects if this is the current item
-                if (currentImageIndex == m_currentIndex) {
-                    addSelectionEffects(itemContainer, rect);
-                }
+QString CustomImageListView::loadKey(int index) const
+{
+    // The decoded size is part of the key, rows can differ in poster size
+    const QSize size = posterDecodeSize(index);
+    return QString("%1@%2x%3").arg(m_model.url(index)).arg(size.width()).arg(size.height());
+}
 
-                // Add title overlay
-                //addTitleOverlay(itemContainer, rect, imgData.title);
+void CustomImageListView::setItemTexture(int index, QSGTexture *texture)
+{
+    TexturedNode &node = m_nodes[index];
+    if (node.texture == texture) {
+        return;
+    }
+    releaseItemTexture(node.texture);
+    node.texture = texture;
+    m_textureResidency.addRef(texture);
+    m_dirtyTextures.insert(index);
+    update();
+}
 
-                // Add the container to parent
-                parentNode->appendChildNode(itemContainer);
-                currentImageIndex++;
-                xPos += dims.posterWidth + dims.itemSpacing;
-            }
+// Shared textures stay resident until evicted, fallbacks are retired
+// right away
+void CustomImageListView::releaseItemTexture(QSGTexture *texture)
+{
+    if (m_textureResidency.contains(texture)) {
+        m_textureResidency.release(texture);
+        return;
+    }
+    retireTexture(texture);
+}
+
+// The leader's load is done: the waiting items get the same texture, or
+// their own fallback when it failed
+void CustomImageListView::finishInFlightKey(int leader, QSGTexture *texture)
+{
+    const QString key = m_inFlightIndexKeys.take(leader);
+    auto inFlight = m_inFlightKeys.find(key);
+    if (inFlight == m_inFlightKeys.end() || inFlight->leader != leader) {
+        return;
+    }
+    const QList<int> followers = inFlight->followers.keys();
+    m_inFlightKeys.erase(inFlight);
+
+    for (int index : followers) {
+        m_inFlightIndexKeys.remove(index);
+        if (texture) {
+            setItemTexture(index, texture);
+        } else {
+            createFallbackTexture(index);
         }
-        
-        currentY += dims.rowHeight + m_rowSpacing;
     }
-    
-    // // Before returning, update metrics with accurate counts
-    // if (m_enableNodeMetrics) {
-    //     int realNodeCount = countNodes(parentNode);
-    //     qDebug() << "Scene graph node metrics - Nodes:" << realNodeCount;
-        
-    //     if (m_enableTextureMetrics) {
-    //         int realTextureCount = countTotalTextures(parentNode);
-    //         qDebug() << "Scene graph texture metrics - Textures:" << realTextureCount;
-    //         updateMetricCounts(realNodeCount, realTextureCount);
-    //     } else {
-            
-    //         updateMetricCounts(realNodeCount, 0);
-    //     }
-    // }
-    
-    return parentNode;
 }
 
-// Helper method for selection effects
-void CustomImageListView::addSelectionEffects(QSGNode* container, const QRectF& rect)
+void CustomImageListView::retireTexture(QSGTexture *texture)
 {
-    // Calculate scaled dimensions for focus border to match zoomed asset
-    const float scaleFactor = 1.1f;  // Match the zoom factor from createTexturedRect
-    qreal widthDiff = rect.width() * (scaleFactor - 1.0f);
-    qreal heightDiff = rect.height() * (scaleFactor - 1.0f);
-    
-    QRectF scaledRect(
-        rect.x() - widthDiff / 2,
-        rect.y() - heightDiff / 2,
-        rect.width() * scaleFactor,
-        rect.height() * scaleFactor
-    );
-    
-    // Create white border effect
-    QSGGeometryNode *borderNode = new QSGGeometryNode;
-    
-    // Create geometry for border (4 lines forming a rectangle)
-    QSGGeometry *borderGeometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), 8);
-    borderGeometry->setDrawingMode(GL_LINES);
-    borderGeometry->setLineWidth(2); // Border width
-    
-    QSGGeometry::Point2D *vertices = borderGeometry->vertexDataAsPoint2D();
-    
-    // Top line
-    vertices[0].set(scaledRect.left(), scaledRect.top());
-    vertices[1].set(scaledRect.right(), scaledRect.top());
-    
-    // Right line
-    vertices[2].set(scaledRect.right(), scaledRect.top());
-    vertices[3].set(scaledRect.right(), scaledRect.bottom());
-    
-    // Bottom line
-    vertices[4].set(scaledRect.right(), scaledRect.bottom());
-    vertices[5].set(scaledRect.left(), scaledRect.bottom());
-    
-    // Left line
-    vertices[6].set(scaledRect.left(), scaledRect.bottom());
-    vertices[7].set(scaledRect.left(), scaledRect.top());
-    
-    borderNode->setGeometry(borderGeometry);
-    borderNode->setFlag(QSGNode::OwnsGeometry);
-    
-    // Create white material for border
-    QSGFlatColorMaterial *borderMaterial = new QSGFlatColorMaterial;
-    borderMaterial->setColor(QColor(Qt::white));
-    
-    borderNode->setMaterial(borderMaterial);
-    borderNode->setFlag(QSGNode::OwnsMaterial);
-    
-    container->appendChildNode(borderNode);
+    if (texture && !m_retiredTextures.contains(texture)) {
+        m_retiredTextures.append(texture);
+        update();
+    }
 }
 
-// Helper method for title overlay
-void CustomImageListView::addTitleOverlay(QSGNode* container, const QRectF& rect, const QString& title)
+void CustomImageListView::rebuildRowNodes(SwimlaneRootNode *rootNode)
 {
-    QRectF textRect(rect.left(), rect.bottom() - 40, rect.width(), 40);
-    
-    // Add semi-transparent background
-    QSGGeometryNode *textBgNode = new QSGGeometryNode;
-    QSGGeometry *bgGeometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), 4);
-    bgGeometry->setDrawingMode(GL_TRIANGLE_STRIP);
-    
-    QSGGeometry::Point2D *bgVertices = bgGeometry->vertexDataAsPoint2D();
-    bgVertices[0].set(textRect.left(), textRect.top());
-    bgVertices[1].set(textRect.right(), textRect.top());
-    bgVertices[2].set(textRect.left(), textRect.bottom());
-    bgVertices[3].set(textRect.right(), textRect.bottom());
-    
-    textBgNode->setGeometry(bgGeometry);
-    textBgNode->setFlag(QSGNode::OwnsGeometry);
-    
-    QSGFlatColorMaterial *bgMaterial = new QSGFlatColorMaterial;
-    bgMaterial->setColor(QColor(0, 0, 0, 128));
-    textBgNode->setMaterial(bgMaterial);
-    textBgNode->setFlag(QSGNode::OwnsMaterial);
-    
-    container->appendChildNode(textBgNode);
+    rootNode->clearRows();
+
+    // Items are stored row by row, so each row owns a contiguous index range
+    const LayoutEngine &layout = this->layout();
+    for (int row = 0; row < layout.rowCount(); ++row) {
+        // Titles and posters are created lazily once the row becomes visible
+        rootNode->appendRow(new SwimlaneRowNode(row, layout.firstItem(row), layout.itemCount(row),
+                                                rootNode->pool()));
+    }
 
-    // Add text
-    QSGGeometryNode *textNode = createOptimizedTextNode(title, textRect);
-    if (textNode) {
-        container->appendChildNode(textNode);
+    // Everything will be materialized from current state
+    m_dirtyTextures.clear();
+    m_paintedFocusIndex = -1;
+    if (rootNode->animator()) {
+        rootNode->animator()->clearRows();
     }
 }
 
+void CustomImageListView::appendRowNodes(SwimlaneRootNode *rootNode)
+{
+    // Streamed rows only ever go below the others, the rows already shown
+    // keep their posters and running animations
+    const LayoutEngine &layout = this->layout();
+    for (int row = rootNode->rows().size(); row < layout.rowCount(); ++row) {
+        rootNode->appendRow(new SwimlaneRowNode(row, layout.firstItem(row), layout.itemCount(row),
+                                                rootNode->pool()));
+    }
+}
+
+void CustomImageListView::updateRowNode(SwimlaneRowNode *rowNode, qreal rowY, bool relayout,
+                                        SwimlaneAnimator *animator)
+{
+    const int row = rowNode->row();
+    const QString &categoryName = m_rowTitles[row];
+    const LayoutEngine &layout = this->layout();
+
+    // Posters and text live in row content coordinates, scrolling either way
+    // only moves the row and scroll transforms. Key navigation animates the
+    // scroll transform on the render thread, direct scrolling jumps.
+    const qreal originX = rowOriginX(row);
+    rowNode->setRowY(rowY);
+    if (m_animatedRows.contains(row)) {
+        animator->scrollRow(row, originX, SCROLL_DURATION);
+    } else if (m_dirtyRows.contains(row)) {
+        animator->scrollRow(row, originX, 0);
+    } else {
+        animator->retargetRow(row, originX);
+    }
+    rowNode->setClipRect(QRectF(0, 0, width(), layout.rowPitch(row)));
+
+    // Work out which columns intersect the viewport extended by cacheBuffer,
+    // anywhere between where the animations start and where they end
+    qreal minX = originX;
+    qreal maxX = originX;
+    animator->rowScrollRange(row, &minX, &maxX);
+
+    int first = 0;
+    int last = -1;
+    qreal rowBottom = rowY + layout.posterOffset() + layout.dimensions(row).rowHeight;
+    bool rowVisible = rowBottom >= m_syncContentMinY - m_cacheBuffer
+                   && rowY <= m_syncContentMaxY + height() + m_cacheBuffer;
+    if (rowVisible && !layout.columnRange(row, -m_cacheBuffer - maxX, width() + m_cacheBuffer - minX,
+                                          &first, &last)) {
+        first = 0;
+        last = -1;
+    }
+    const bool rangeChanged = first != rowNode->materializedFirst() || last != rowNode->materializedLast();
+    rowNode->setMaterializedRange(first, last);
+
+    // Titles come from the shared cache, so rows far away can drop theirs
+    if (rowVisible && !rowNode->titleNode()) {
+        QSGTexture *titleTexture = nullptr;
+        QSGGeometryNode *titleNode = createRowTitleNode(categoryName,
+                                                        QRectF(0, 0, 0, m_titleHeight),
+                                                        &titleTexture);
+        rowNode->setTitleNode(titleNode, titleTexture);
+    } else if (!rowVisible && rowNode->titleNode()) {
+        rowNode->setTitleNode(nullptr, nullptr);
+    }
+    // Same 8px left offset createRowTitleNode applies to the title
+    rowNode->setTitlePosition(QPointF(m_startPositionX + 10 - 8, 0));
+
+    // Nothing entered or left the range, the matrices were all that changed
+    if (!relayout && !rangeChanged) {
+        return;
+    }
+
+    // Reposition the posters we kept and pick up the ones that scrolled in
+    for (int column = first; column <= last; ++column) {
+        int index = rowNode->firstIndex() + column;
+        PosterNode *poster = rowNode->poster(index);
+        if (!poster) {
+            // Every poster gets a node right away, the ones still loading
+            // show their placeholder so the first frame never waits
+            auto it = m_nodes.constFind(index);
+            QSGTexture *texture = it != m_nodes.constEnd() ? it.value().texture : nullptr;
+            poster = rowNode->ensurePoster(index);
+            poster->setPlaceholderColor(placeholderColor(index));
+            poster->setTexture(texture);
+            poster->setReveal(texture ? 1 : 0);
+            poster->setFocused(index == m_paintedFocusIndex);
+        }
+        poster->setRect(posterRect(index));
+    }
+
+    updateRowText(rowNode);
+}
+
+void CustomImageListView::updateRowText(SwimlaneRowNode *rowNode)
+{
+    const int first = rowNode->materializedFirst();
+    const int last = rowNode->materializedLast();
+    if (last < first) {
+        rowNode->setTextNode(nullptr);
+        return;
+    }
+
+    GlyphCache &glyphs = GlyphCache::instance();
+    GlyphTextNode *textNode = rowNode->textNode();
+    if (!textNode) {
+        QSGTexture *pageTexture = glyphs.pageTexture(window());
+        if (!pageTexture) {
+            return;
+        }
+        textNode = new GlyphTextNode(pageTexture, glyphs.solidRect(window()));
+        rowNode->setTextNode(textNode);
+    }
+
+    static const QFont titleFont("Arial", 12, QFont::Bold);
+    static const QFont infoFont("Arial", 10);
+    static const QColor titleColor(Qt::white);
+    static const QColor infoColor("#b3b3b3");
+    static const QColor overlayColor(0, 0, 0, 160);
+    const qreal padding = 4;
+
+    const LayoutEngine::RowDimensions &dims = layout().dimensions(rowNode->row());
+    const qreal textWidth = dims.posterWidth - 2 * padding;
+    const qreal bandHeight = dims.rowHeight - dims.posterHeight;
+
+    textNode->clear();
+    for (int column = first; column <= last; ++column) {
+        int index = rowNode->firstIndex() + column;
+        if (index >= m_model.size()) {
+            break;
+        }
+
+        // Shaped runs are cached, this is only hash lookups after the first frame
+        const GlyphCache::TextRun lines[] = {
+            glyphs.textRun(window(), m_model.title(index), titleFont, textWidth),
+            glyphs.textRun(window(), m_model.programInfo(index), infoFont, textWidth),
+            glyphs.textRun(window(), m_model.remainingTimeText(index), infoFont, textWidth)
+        };
+        const QColor lineColors[] = { titleColor, infoColor, infoColor };
+
+        qreal blockHeight = 0;
+        for (const GlyphCache::TextRun &line : lines) {
+            blockHeight += line.height;
+        }
+        if (blockHeight <= 0) {
+            continue;
+        }
+        blockHeight += 2 * padding;
+
+        QRectF rect = posterRect(index);
+        if (index == m_paintedFocusIndex) {
+            rect = focusedPosterRect(rect);
+        }
+
+        // Rows with a metadata band get the text under the poster, otherwise
+        // it overlays the bottom of the poster on a dark strip
+        qreal y = rect.bottom() + padding;
+        if (bandHeight < blockHeight) {
+            QRectF background(rect.left(), rect.bottom() - blockHeight, rect.width(), blockHeight);
+            textNode->addRect(background, overlayColor);
+            y = background.top() + padding;
+        }
+        for (int i = 0; i < 3; ++i) {
+            textNode->addText(lines[i], QPointF(rect.left() + padding, y), lineColors[i]);
+            y += lines[i].height;
+        }
+    }
+    textNode->commit();
+}
+
+QRectF CustomImageListView::posterRect(int index) const
+{
+    // Row content coordinates, the row's transforms add scroll and row y
+    return layout().itemRect(index);
+}
+
 // Add this new function
 void CustomImageListView::debugResourceSystem() const 
 {
@@ -1062,21 +1637,9 @@ void CustomImageListView::setCurrentIndex(int index)
         updateCurrentCategory();
         
         // Emit full JSON data when focus changes
-        if (index < m_imageData.size()) {
-            const ImageData &currentItem = m_imageData[index];
-            
-            // Find original JSON object
-            QJsonArray items = m_parsedJson["menuItems"].toObject()["items"].toArray();
-            for (const QJsonValue &rowVal : items) {
-                QJsonArray rowItems = rowVal.toObject()["items"].toArray();
-                for (const QJsonValue &itemVal : rowItems) {
-                    QJsonObject item = itemVal.toObject();
-                    if (item["title"].toString() == currentItem.title) {
-                        emit assetFocused(item);
-                        break;
-                    }
-                }
-            }
+        const QJsonObject item = sourceJson(index);
+        if (!item.isEmpty()) {
+            emit assetFocused(item);
         }
         
         emit currentIndexChanged();
@@ -1084,9 +1647,36 @@ void CustomImageListView::setCurrentIndex(int index)
     }
 }
 
+// The item's object as it is in the catalog, parsed from its recorded
+// byte range. Empty for items that did not come from the catalog and
+// until the catalog's bytes are in; after a start from the snapshot the
+// first call has them read on the parser's worker.
+QJsonObject CustomImageListView::sourceJson(int index)
+{
+    if (index < 0 || index >= m_model.size()) {
+        return QJsonObject();
+    }
+    const int sourceOffset = m_model.sourceOffset(index);
+    const int sourceLength = m_model.sourceLength(index);
+    if (sourceOffset < 0) {
+        return QJsonObject();
+    }
+    if (m_catalogDataState == CatalogDataUnread) {
+        m_catalogDataState = CatalogDataReading;
+        m_catalogParser->readSource(m_catalogPath);
+        return QJsonObject();
+    }
+    if (qint64(sourceOffset) + sourceLength > m_catalogData.size()) {
+        return QJsonObject();
+    }
+    return QJsonDocument::fromJson(QByteArray::fromRawData(m_catalogData.constData() + sourceOffset,
+                                                           sourceLength)).object();
+}
+
 void CustomImageListView::keyPressEvent(QKeyEvent *event)
 {
     qDebug() << "Key pressed:" << event->key() << "Has focus:" << hasActiveFocus();
+    const int previousIndex = m_currentIndex;
     
     switch (event->key()) {
         case Qt::Key_Return:
@@ -1101,355 +1691,193 @@ void CustomImageListView::keyPressEvent(QKeyEvent *event)
             break;
         case Qt::Key_Left:        // Add back left navigation
             navigateLeft();
+            onNavigated(NavigationPrefetcher::Left, previousIndex);
             event->accept();
             break;
         case Qt::Key_Right:       // Add back right navigation
             navigateRight();
+            onNavigated(NavigationPrefetcher::Right, previousIndex);
             event->accept();
             break;
         case Qt::Key_Up:
             navigateUp();
+            onNavigated(NavigationPrefetcher::Up, previousIndex);
             event->accept();
-            break;
-        case Qt::Key_Down:
-            navigateDown();
-            event->accept();
-            break;
-        default:
-            QQuickItem::keyPressEvent(event);
-    }
-}
-
-void CustomImageListView::handleKeyAction(Qt::Key key)
-{
-    if (m_currentIndex < 0 || m_currentIndex >= m_imageData.size()) {
-        return;
-    }
-
-    const ImageData &currentItem = m_imageData[m_currentIndex];
-    qDebug() << "Handling key action for item:" << currentItem.title;
-    qDebug() << "Available links:" << currentItem.links;
-    
-    if (key == Qt::Key_Return || key == Qt::Key_Enter || key == Qt::Key_Space) {
-        // Try OK action
-        if (currentItem.links.contains("OK")) {
-            qDebug() << "Emitting OK link:" << currentItem.links["OK"];
-            emit linkActivated("OK", currentItem.links["OK"]);
-        }
-    }
-    else if (key == Qt::Key_I) {
-        // Try info action
-        if (currentItem.links.contains("INFO")) {
-            qDebug() << "Emitting info link:" << currentItem.links["INFO"];
-            emit linkActivated("INFO", currentItem.links["INFO"]);
-        }
-    }
-}
-
-void CustomImageListView::navigateLeft()
-{
-    QString currentCategory = m_imageData[m_currentIndex].category;
-    int prevIndex = m_currentIndex - 1;
-    
-    while (prevIndex >= 0) {
-        if (m_imageData[prevIndex].category != currentCategory) {
-            break;
-        }
-        setCurrentIndex(prevIndex);
-        ensureIndexVisible(prevIndex);
-        ensureFocus();
-        updateCurrentCategory();
-        update();
-        return;
-    }
-}
-
-void CustomImageListView::navigateRight()
-{
-    QString currentCategory = m_imageData[m_currentIndex].category;
-    int nextIndex = m_currentIndex + 1;
-    
-    while (nextIndex < m_imageData.size()) {
-        if (m_imageData[nextIndex].category != currentCategory) {
-            break;
-        }
-        
-        // Get category dimensions and calculate if scrolling is needed
-        CategoryDimensions dims = getDimensionsForCategory(currentCategory);
-        int itemsInCategory = 0;
-        int lastIndexInCategory = nextIndex;
-        
-        // Count items in this category and find last index
-        for (int i = 0; i < m_imageData.size(); i++) {
-            if (m_imageData[i].category == currentCategory) {
-                itemsInCategory++;
-                lastIndexInCategory = i;
-            }
-        }
-        
-        setCurrentIndex(nextIndex);
-        ensureIndexVisible(nextIndex);
-        ensureFocus();
-        updateCurrentCategory();
-        
-        // Calculate scroll target position with animation
-        qreal totalWidth = itemsInCategory * dims.posterWidth + 
-                          (itemsInCategory - 1) * dims.itemSpacing;
-                          
-        if (totalWidth > width()) {
-            qreal targetX;
-            if (nextIndex == lastIndexInCategory) {
-                targetX = categoryContentWidth(currentCategory) - width();
-            } else {
-                int itemsBeforeInCategory = 0;
-                for (int i = 0; i < nextIndex; i++) {
-                    if (m_imageData[i].category == currentCategory) {
-                        itemsBeforeInCategory++;
-                    }
-                }
-                targetX = itemsBeforeInCategory * (dims.posterWidth + dims.itemSpacing);
-                targetX = qMax(0.0, targetX - (width() - dims.posterWidth) / 2);
-            }
-            
-            // Animate to target position
-            animateScroll(currentCategory, targetX);
-        }
-        
-        update();
-        return;
+            break;
+        case Qt::Key_Down:
+            navigateDown();
+            onNavigated(NavigationPrefetcher::Down, previousIndex);
+            event->accept();
+            break;
+        default:
+            QQuickItem::keyPressEvent(event);
     }
 }
 
-// Update navigateUp and navigateDown methods
-void CustomImageListView::navigateUp()
+void CustomImageListView::handleKeyAction(Qt::Key key)
 {
-    if (m_currentIndex < 0 || m_rowTitles.isEmpty()) {
+    if (m_currentIndex < 0 || m_currentIndex >= m_model.size()) {
         return;
     }
 
-    QString currentCategory = m_imageData[m_currentIndex].category;
-    int categoryIndex = m_rowTitles.indexOf(currentCategory);
+    qDebug() << "Handling key action for item:" << m_model.title(m_currentIndex);
     
-    if (categoryIndex > 0) {
-        QString prevCategory = m_rowTitles[categoryIndex - 1];
-        CategoryDimensions prevDims = getDimensionsForCategory(prevCategory);
-        
-        // Get current horizontal scroll position for the target category
-        qreal categoryScrollX = getCategoryContentX(prevCategory);
-        
-        // Find first visible item in the previous category
-        int firstVisibleIndex = -1;
-        qreal bestDistance = std::numeric_limits<qreal>::max();
-        
-        for (int i = 0; i < m_imageData.size(); i++) {
-            if (m_imageData[i].category == prevCategory) {
-                // Calculate item's x position
-                int itemsBeforeThis = 0;
-                for (int j = 0; j < i; j++) {
-                    if (m_imageData[j].category == prevCategory) {
-                        itemsBeforeThis++;
-                    }
-                }
-                
-                qreal itemX = itemsBeforeThis * (prevDims.posterWidth + prevDims.itemSpacing);
-                
-                // Check if item is visible (considering scroll position)
-                if (itemX >= categoryScrollX && 
-                    itemX < (categoryScrollX + width() - prevDims.posterWidth)) {
-                    qreal distanceFromLeft = itemX - categoryScrollX;
-                    if (distanceFromLeft < bestDistance) {
-                        bestDistance = distanceFromLeft;
-                        firstVisibleIndex = i;
-                    }
-                }
-            }
+    if (key == Qt::Key_Return || key == Qt::Key_Enter || key == Qt::Key_Space) {
+        // Try OK action
+        const QString &href = m_model.link(m_currentIndex, CatalogModel::OkLink);
+        if (!href.isEmpty()) {
+            qDebug() << "Emitting OK link:" << href;
+            emit linkActivated(CatalogModel::eventName(CatalogModel::OkLink), href);
         }
-        
-        // If we found a visible item, select it
-        if (firstVisibleIndex != -1) {
-            setCurrentIndex(firstVisibleIndex);
-            ensureIndexVisible(firstVisibleIndex);
-            ensureFocus();
-            update();
-        } else {
-            // Fallback to first item in category if none are visible
-            for (int i = 0; i < m_imageData.size(); i++) {
-                if (m_imageData[i].category == prevCategory) {
-                    setCurrentIndex(i);
-                    ensureIndexVisible(i);
-                    ensureFocus();
-                    update();
-                    break;
-                }
-            }
+    }
+    else if (key == Qt::Key_I) {
+        // Try info action
+        const QString &href = m_model.link(m_currentIndex, CatalogModel::InfoLink);
+        if (!href.isEmpty()) {
+            qDebug() << "Emitting info link:" << href;
+            emit linkActivated(CatalogModel::eventName(CatalogModel::InfoLink), href);
         }
     }
 }
 
-void CustomImageListView::navigateDown()
+void CustomImageListView::navigateLeft()
 {
-    if (m_currentIndex < 0 || m_rowTitles.isEmpty()) {
+    // Items of a row are stored next to each other
+    const LayoutEngine &layout = this->layout();
+    const int row = layout.rowForItem(m_currentIndex);
+    if (row < 0 || m_currentIndex == layout.firstItem(row)) {
         return;
     }
 
-    QString currentCategory = m_imageData[m_currentIndex].category;
-    int categoryIndex = m_rowTitles.indexOf(currentCategory);
-    
-    if (categoryIndex < m_rowTitles.size() - 1) {
-        QString nextCategory = m_rowTitles[categoryIndex + 1];
-        CategoryDimensions nextDims = getDimensionsForCategory(nextCategory);
-        
-        // Get current horizontal scroll position for the target category
-        qreal categoryScrollX = getCategoryContentX(nextCategory);
-        
-        // Find first visible item in the next category
-        int firstVisibleIndex = -1;
-        qreal bestDistance = std::numeric_limits<qreal>::max();
-        
-        for (int i = 0; i < m_imageData.size(); i++) {
-            if (m_imageData[i].category == nextCategory) {
-                // Calculate item's x position
-                int itemsBeforeThis = 0;
-                for (int j = 0; j < i; j++) {
-                    if (m_imageData[j].category == nextCategory) {
-                        itemsBeforeThis++;
-                    }
-                }
-                
-                qreal itemX = itemsBeforeThis * (nextDims.posterWidth + nextDims.itemSpacing);
-                
-                // Check if item is visible (considering scroll position)
-                if (itemX >= categoryScrollX && 
-                    itemX < (categoryScrollX + width() - nextDims.posterWidth)) {
-                    qreal distanceFromLeft = itemX - categoryScrollX;
-                    if (distanceFromLeft < bestDistance) {
-                        bestDistance = distanceFromLeft;
-                        firstVisibleIndex = i;
-                    }
-                }
-            }
-        }
-        
-        // If we found a visible item, select it
-        if (firstVisibleIndex != -1) {
-            setCurrentIndex(firstVisibleIndex);
-            ensureIndexVisible(firstVisibleIndex);
-            ensureFocus();
-            update();
+    int prevIndex = m_currentIndex - 1;
+    setCurrentIndex(prevIndex);
+    ensureIndexVisible(prevIndex);
+    ensureFocus();
+    updateCurrentCategory();
+    update();
+}
+
+void CustomImageListView::navigateRight()
+{
+    const LayoutEngine &layout = this->layout();
+    const int row = layout.rowForItem(m_currentIndex);
+    if (row < 0) {
+        return;
+    }
+    const int nextIndex = m_currentIndex + 1;
+    const int lastIndexInCategory = layout.firstItem(row) + layout.itemCount(row) - 1;
+    if (nextIndex > lastIndexInCategory) {
+        return;
+    }
+
+    setCurrentIndex(nextIndex);
+    ensureIndexVisible(nextIndex);
+    ensureFocus();
+    updateCurrentCategory();
+
+    // Calculate scroll target position with animation
+    if (layout.rowContentWidth(row) > width()) {
+        qreal targetX;
+        if (nextIndex == lastIndexInCategory) {
+            targetX = categoryContentWidth(row) - width();
         } else {
-            // Fallback to first item in category if none are visible
-            for (int i = 0; i < m_imageData.size(); i++) {
-                if (m_imageData[i].category == nextCategory) {
-                    setCurrentIndex(i);
-                    ensureIndexVisible(i);
-                    ensureFocus();
-                    update();
-                    break;
-                }
-            }
+            targetX = layout.itemRect(nextIndex).x();
+            targetX = qMax(0.0, targetX - (width() - layout.dimensions(row).posterWidth) / 2);
         }
+
+        // Animate to target position
+        animateScroll(row, targetX);
     }
+
+    update();
 }
 
-// Add this helper method to calculate item's vertical position
-qreal CustomImageListView::calculateItemVerticalPosition(int index)
+void CustomImageListView::navigateUp()
 {
-    if (index < 0 || index >= m_imageData.size()) {
-        return 0;
+    const int row = layout().rowForItem(m_currentIndex);
+    if (row > 0) {
+        navigateToRow(row - 1);
     }
+}
 
-    qreal position = 0;
-    QString targetCategory = m_imageData[index].category;
-    
-    for (const QString &category : m_rowTitles) {
-        CategoryDimensions dims = getDimensionsForCategory(category);
-        
-        // Add spacing between categories
-        if (position > 0) {
-            position += m_rowSpacing;
-        }
-
-        // Add title height
-        position += m_titleHeight;
+void CustomImageListView::navigateDown()
+{
+    const int row = layout().rowForItem(m_currentIndex);
+    if (row >= 0) {
+        navigateToRow(row + 1);
+    }
+}
 
-        if (category == targetCategory) {
-            break;
-        }
+// Focuses the first poster of the row that is fully on screen at the row's
+// current scroll position, or the row's first poster if none is
+void CustomImageListView::navigateToRow(int row)
+{
+    const LayoutEngine &layout = this->layout();
+    if (row < 0 || row >= layout.rowCount() || layout.itemCount(row) == 0) {
+        return;
+    }
 
-        // Add row height
-        position += dims.rowHeight;
+    const qreal categoryScrollX = getCategoryContentX(row);
+    const qreal stride = layout.stride(row);
+    int column = stride > 0 ? qMax(0, int(std::ceil(categoryScrollX / stride))) : 0;
+    if (column >= layout.itemCount(row)
+        || column * stride >= categoryScrollX + width() - layout.dimensions(row).posterWidth) {
+        column = 0;
     }
 
-    return position;
+    const int index = layout.firstItem(row) + column;
+    setCurrentIndex(index);
+    ensureIndexVisible(index);
+    ensureFocus();
+    update();
 }
 
 void CustomImageListView::ensureIndexVisible(int index)
 {
-    if (index < 0 || index >= m_imageData.size()) {
+    const LayoutEngine &layout = this->layout();
+    const int row = layout.rowForItem(index);
+    if (row < 0) {
         return;
     }
 
-    QString targetCategory = m_imageData[index].category;
-    CategoryDimensions dims = getDimensionsForCategory(targetCategory);
+    const LayoutEngine::RowDimensions &dims = layout.dimensions(row);
     
-    // Calculate vertical position
-    qreal targetY = calculateItemVerticalPosition(index);
-    
-    // Center vertically with proper offset
+    // Center the row's posters vertically
     qreal centerOffset = (height() - dims.posterHeight) / 2;
-    qreal newContentY = targetY - centerOffset;
+    qreal newContentY = layout.posterTop(row) - centerOffset;
     
     // Bound the scroll position
     newContentY = qBound(0.0, newContentY, qMax(0.0, contentHeight() - height()));
-    setContentY(newContentY);
-    
-    // Handle horizontal scrolling
-    int itemsBeforeInCategory = 0;
-    for (int i = 0; i < index; i++) {
-        if (m_imageData[i].category == targetCategory) {
-            itemsBeforeInCategory++;
-        }
-    }
-    
-    // Calculate x position considering item dimensions
-    qreal xOffset = itemsBeforeInCategory * (dims.posterWidth + dims.itemSpacing);
+    animateContentY(newContentY);
     
     // Center the item horizontally with proper offset
-    qreal targetX = xOffset - (width() - dims.posterWidth) / 2;
+    qreal targetX = layout.itemRect(index).x() - (width() - dims.posterWidth) / 2;
     
     // Add extra space to ensure focus border is visible
     qreal extraSpace = 10; // Pixels for focus border visibility
     
     // Calculate maximum scroll considering item width and spacing
-    qreal maxScroll = categoryContentWidth(targetCategory) - width();
+    qreal maxScroll = categoryContentWidth(row) - width();
     
     // Bound the scroll position with extra space consideration
     targetX = qBound(0.0, targetX, maxScroll + extraSpace);
     
-    setCategoryContentX(targetCategory, targetX);
+    animateScroll(row, targetX);
 }
 
 // Add helper method to calculate category width
-qreal CustomImageListView::categoryContentWidth(const QString& category) const
+qreal CustomImageListView::categoryContentWidth(int row) const
 {
-    // Get the correct dimensions for this category
-    CategoryDimensions dims = getDimensionsForCategory(category);
-    
-    // Count items in this category
-    int itemCount = 0;
-    for (const ImageData &imgData : m_imageData) {
-        if (imgData.category == category) {
-            itemCount++;
-        }
+    const LayoutEngine &layout = this->layout();
+    if (row < 0 || row >= layout.rowCount()) {
+        return 0;
     }
-    
-    // Calculate total width using category-specific dimensions
-    qreal totalWidth = itemCount * dims.posterWidth + 
-                       (itemCount - 1) * dims.itemSpacing;
+
+    qreal totalWidth = layout.rowContentWidth(row);
                        
     // Only add padding if the content is wider than the view
     if (totalWidth > width()) {
-        totalWidth += dims.posterWidth * 0.5; // Add half poster width as padding
+        totalWidth += layout.dimensions(row).posterWidth * 0.5; // Add half poster width as padding
     }
     
     return totalWidth;
@@ -1470,6 +1898,15 @@ bool CustomImageListView::event(QEvent *e)
 void CustomImageListView::mousePressEvent(QMouseEvent *event)
 {
     ensureFocus();
+
+    // Clicking a poster focuses it
+    const int index = indexAt(event->localPos());
+    if (index >= 0 && index != m_currentIndex) {
+        setCurrentIndex(index);
+        ensureIndexVisible(index);
+        updateCurrentCategory();
+        update();
+    }
     QQuickItem::mousePressEvent(event);
 }
 
@@ -1521,6 +1958,7 @@ void CustomImageListView::setContentY(qreal y)
 {
     if (m_contentY != y) {
         m_contentY = y;
+        m_sceneDirty |= SceneScrollDirty;
         emit contentYChanged();
         
         // Add this call to check visibility on scroll
@@ -1535,47 +1973,10 @@ qreal CustomImageListView::contentWidth() const
     return m_itemsPerRow * m_itemWidth + (m_itemsPerRow - 1) * m_spacing;
 }
 
-// Update contentHeight calculation for tighter spacing
+// Same rows the scene graph draws
 qreal CustomImageListView::contentHeight() const
 {
-    qreal totalHeight = 0;
-    
-    // Add minimal initial padding
-    totalHeight += m_rowSpacing / 2;  // Reduced padding
-    
-    for (int categoryIndex = 0; categoryIndex < m_rowTitles.size(); ++categoryIndex) {
-        // Add minimal spacing between categories
-        if (categoryIndex > 0) {
-            totalHeight += m_rowSpacing;  // Reduced from double spacing
-        }
-
-        // Add category title height
-        totalHeight += m_titleHeight;
-
-        QString categoryName = m_rowTitles[categoryIndex];
-        int categoryImageCount = 0;
-        for (const ImageData &imgData : m_imageData) {
-            if (imgData.category == categoryName) {
-                categoryImageCount++;
-            }
-        }
-
-        // Calculate rows needed for this category
-        int rowsInCategory = (categoryImageCount + m_itemsPerRow - 1) / m_itemsPerRow;
-        
-        // Add height for all rows in this category
-        totalHeight += rowsInCategory * m_itemHeight;
-        
-        // Add minimal spacing between rows within category
-        if (rowsInCategory > 1) {
-            totalHeight += (rowsInCategory - 1) * (m_rowSpacing / 2);  // Reduced internal row spacing
-        }
-    }
-
-    // Add minimal padding at bottom
-    totalHeight += m_rowSpacing / 2;  // Reduced padding
-    
-    return totalHeight;
+    return layout().contentHeight();
 }
 
 // Update wheelEvent to handle per-category scrolling
@@ -1583,11 +1984,11 @@ void CustomImageListView::wheelEvent(QWheelEvent *event)
 {
     if (event->modifiers() & Qt::ShiftModifier) {
         // Horizontal scrolling within current category
-        QString currentCategory = m_imageData[m_currentIndex].category;
+        const int currentRow = layout().rowForItem(m_currentIndex);
         qreal horizontalDelta = event->angleDelta().x() / 120.0 * m_itemWidth;
         qreal newX = m_contentX - horizontalDelta;
-        newX = qBound(0.0, newX, qMax(0.0, categoryContentWidth(currentCategory) - width()));
-        setCategoryContentX(currentCategory, newX);
+        newX = qBound(0.0, newX, qMax(0.0, categoryContentWidth(currentRow) - width()));
+        setCategoryContentX(currentRow, newX);
     } else {
         // Vertical scrolling between categories
         qreal verticalDelta = event->angleDelta().y() / 120.0 * m_itemHeight;
@@ -1605,22 +2006,11 @@ void CustomImageListView::cleanupNode(TexturedNode& node)
         delete node.node;
         node.node = nullptr;
     }
-    // Don't delete texture, just clear the pointer
+    // The scene graph may still use the texture, delete it on the render thread
+    releaseItemTexture(node.texture);
     node.texture = nullptr;
 }
 
-void CustomImageListView::limitTextureCacheSize(int maxTextures)
-{
-    if (m_nodes.size() > maxTextures) {
-        // Remove oldest textures
-        auto it = m_nodes.begin();
-        while (m_nodes.size() > maxTextures && it != m_nodes.end()) {
-            cleanupNode(it.value());
-            it = m_nodes.erase(it);
-        }
-    }
-}
-
 // Update cleanupTextures
 void CustomImageListView::cleanupTextures()
 {
@@ -1628,6 +2018,7 @@ void CustomImageListView::cleanupTextures()
         cleanupNode(it.value());
     }
     m_nodes.clear();
+    m_sceneDirty |= SceneModelDirty;
 }
 
 void CustomImageListView::setJsonSource(const QUrl &source)
@@ -1642,11 +2033,7 @@ void CustomImageListView::setJsonSource(const QUrl &source)
 void CustomImageListView::loadFromJson(const QUrl &source)
 {
     qDebug() << "Loading JSON from source:" << source.toString();
-    
-    // First load UI settings
-    loadUISettings();
-    
-    // Then load menu data
+
     QString menuPath;
     if (source.scheme() == "qrc") {
         menuPath = ":" + source.path();
@@ -1655,43 +2042,38 @@ void CustomImageListView::loadFromJson(const QUrl &source)
         menuPath = source.toLocalFile();
         qDebug() << "Using local file path:" << menuPath;
     }
-    
-    QFile menuFile(menuPath);
-    qDebug() << "Attempting to open file:" << menuPath;
-    qDebug() << "File exists:" << menuFile.exists();
-    
-    if (!menuFile.open(QIODevice::ReadOnly)) {
-        qWarning() << "Failed to load menu data from:" << menuPath 
-                   << "Error:" << menuFile.errorString();
-        
-        // Try alternative path
-        QString altPath = ":/data/embeddedHubMenu.json";
-        QFile altFile(altPath);
-        qDebug() << "Trying alternative path:" << altPath 
-                 << "Exists:" << altFile.exists();
-        
-        if (altFile.open(QIODevice::ReadOnly)) {
-            QByteArray data = altFile.readAll();
-            qDebug() << "Successfully read alternative file, size:" << data.size();
-            processJsonData(data);
-            altFile.close();
-        } else {
-            qWarning() << "Failed to load menu data from alternative path:" << altPath 
-                      << "Error:" << altFile.errorString();
-        }
-    } else {
-        QByteArray data = menuFile.readAll();
-        qDebug() << "Successfully read file, size:" << data.size();
-        menuFile.close();
-        processJsonData(data);
+
+    if (!QFile::exists(menuPath)) {
+        qWarning() << "Menu data not found at:" << menuPath;
+        menuPath = ":/data/embeddedHubMenu.json";
     }
+
+    // Rows show up one by one as the parser gets to them
+    safeReleaseTextures();
+    m_model.clear();
+    m_rowTitles.clear();
+    m_rowItemCounts.clear();
+    m_categoryContentX.clear();
+    m_layoutDirty = true;
+    m_catalogData.clear();
+    m_catalogPath = menuPath;
+    m_catalogDataState = CatalogDataPending;
+    m_count = 0;
+    emit countChanged();
+    emit rowTitlesChanged();
+
+    m_catalogClock.start();
+
+    // An unchanged catalog and UI settings come back from the snapshot
+    // without parsing any JSON
+    m_catalogParser->load(menuPath, QLatin1String(UI_SETTINGS_PATH), &CustomImageListView::loadUISettings);
 }
 
-// Update loadUISettings method
-void CustomImageListView::loadUISettings()
+// Layout values from uiSettings.json, runs on the parser's worker
+QVector<CatalogSnapshot::Dimensions> CustomImageListView::loadUISettings(const QString &path)
 {
-    QString settingsPath = ":/data/uiSettings.json";
-    QFile settingsFile(settingsPath);
+    QVector<CatalogSnapshot::Dimensions> dimensions;
+    QFile settingsFile(path);
     
     if (settingsFile.open(QIODevice::ReadOnly)) {
         QJsonDocument doc = QJsonDocument::fromJson(settingsFile.readAll());
@@ -1711,153 +2093,145 @@ void CustomImageListView::loadUISettings()
             if (posterWithMetaData.contains("portraitType1")) {
                 QJsonObject portraitConfig = posterWithMetaData["portraitType1"].toObject();
                 
-                CategoryDimensions dims;
+                CatalogSnapshot::Dimensions dims;
+                dims.category = "Bein Series";
                 dims.rowHeight = portraitConfig["height"].toInt(240);      // Reduced from 284
                 dims.posterHeight = portraitConfig["posterHeight"].toInt(200); // Reduced from 228
                 dims.posterWidth = portraitConfig["posterWidth"].toInt(152);
                 dims.itemSpacing = 10;  // Reduced from 15
-                
-                m_categoryDimensions["Bein Series"] = dims;
+                dimensions.append(dims);
             }
-            
-            // Set reduced row spacing
-            setRowSpacing(15);  // Reduced from 20
-            
-            // Set reduced row title height
-            m_titleHeight = 30; // Reduced from 30
         }
     }
+    return dimensions;
 }
 
-void CustomImageListView::processJsonData(const QByteArray &data)
+void CustomImageListView::applyUISettings(const QVector<CatalogSnapshot::Dimensions> &dimensions)
 {
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    if (!doc.isObject()) {
-        qWarning() << "Invalid JSON data - not an object";
-        return;
+    for (const CatalogSnapshot::Dimensions &dims : dimensions) {
+        m_categoryDimensions[dims.category] = CategoryDimensions{ dims.rowHeight, dims.posterHeight,
+                                                                  dims.posterWidth, dims.itemSpacing };
     }
 
-    m_parsedJson = doc.object();  // Store the complete JSON object
-    
-    // Get menuItems object first
-    QJsonObject menuItems = m_parsedJson["menuItems"].toObject();
-    if (menuItems.isEmpty()) {
-        qWarning() << "menuItems object is empty or invalid";
-        return;
+    // Set reduced row spacing
+    setRowSpacing(15);  // Reduced from 20
+
+    // Set reduced row title height
+    m_titleHeight = 30; // Reduced from 30
+    m_layoutDirty = true;
+}
+
+void CustomImageListView::onCatalogDimensionsLoaded(const QVector<CatalogSnapshot::Dimensions> &dimensions,
+                                                    bool fromSnapshot)
+{
+    if (fromSnapshot) {
+        qDebug() << "Catalog snapshot is current after" << m_catalogClock.elapsed() << "ms";
+        m_catalogDataState = CatalogDataUnread;
     }
+    applyUISettings(dimensions);
+}
 
-    // Clear existing data
-    m_imageData.clear();
-    m_rowTitles.clear();
+void CustomImageListView::onCatalogRowParsed(const CatalogRow &row)
+{
+    if (m_rowTitles.isEmpty()) {
+        qDebug() << "First catalog row after" << m_catalogClock.elapsed() << "ms";
+    }
+    appendCatalogRow(row);
+    catalogRowsAdded();
+}
 
-    // Process the outer items array (rows)
-    QJsonArray rows = menuItems["items"].toArray();
-    for (const QJsonValue &rowVal : rows) {
-        QJsonObject row = rowVal.toObject();
-        
-        // Get row information
-        QString classificationId = row["classificationId"].toString();
-        QString rowTitle = row["title"].toString();
-        
-        // Add row title
-        m_rowTitles.append(rowTitle);
-        
-        // Process items in this row
-        QJsonArray items = row["items"].toArray();
-        for (const QJsonValue &itemVal : items) {
-            if (!itemVal.isObject()) continue;
-            
-            QJsonObject item = itemVal.toObject();
-            
-            // Skip "viewAll" type items
-            if (item["assetType"].toString() == "viewAll") {
-                continue;
-            }
-            
-            ImageData imgData;
-            imgData.category = rowTitle;  // Use row title as category
-            imgData.title = item["title"].toString();
-            
-            // Get image URL - prioritize moodImageUri then thumbnailUri
-            imgData.url = item["moodImageUri"].toString();
-            if (imgData.url.isEmpty()) {
-                imgData.url = item["thumbnailUri"].toString();
-            }
-            
-            // Add additional metadata
-            imgData.id = item["assetType"].toString();
-            imgData.description = item["shortSynopsis"].toString();
-            
-            // Clean up URL if needed
-            if (imgData.url.startsWith("//")) {
-                imgData.url = "https:" + imgData.url;
-            }
-            
-            // Use default image if no URL
-            if (imgData.url.isEmpty()) {
-                int index = m_imageData.size() % 5 + 1;
-                imgData.url = QString(":/data/images/img%1.jpg").arg(index);
-            }
-            
-            // Process links array
-            QJsonArray links = item["links"].toArray();
-            for (const QJsonValue &linkVal : links) {
-                if (!linkVal.isObject()) continue;
-                
-                QJsonObject link = linkVal.toObject();
-                QString href = link["href"].toString();
-                
-                // Check for events array first
-                QJsonArray events = link["events"].toArray();
-                if (!events.isEmpty()) {
-                    for (const QJsonValue &event : events) {
-                        QString eventType = event.toString().toUpper();
-                        imgData.links[eventType] = href;
-                    }
-                }
-                // Check for single event
-                else if (link.contains("event")) {
-                    QString eventType = link["event"].toString().toUpper();
-                    imgData.links[eventType] = href;
-                }
-            }
-            
-            qDebug() << "Parsed links for" << imgData.title << ":" << imgData.links;
-            m_imageData.append(imgData);
+void CustomImageListView::appendCatalogRow(const CatalogRow &row)
+{
+    // Rows only ever get appended, so the indices of the items already
+    // shown and loading stay valid
+    const int rowId = m_rowTitles.size();
+    m_rowTitles.append(row.title);
+    m_rowItemCounts.append(row.items.size());
+    for (const CatalogItem &item : row.items) {
+        m_model.appendItem(rowId, item);
+
+        // Connects to the image hosts ahead of the first fetch, once per host
+        if (item.url.startsWith("http")) {
+            FetchService::instance().prewarm(QUrl(item.url));
         }
     }
+}
 
-    // Update view
-    m_count = m_imageData.size();
-    if (m_count > 0) {
-        safeReleaseTextures();
-        loadAllImages();
-        emit countChanged();
-        emit rowTitlesChanged();
-        update();
-    } else {
+void CustomImageListView::catalogRowsAdded()
+{
+    // The layout picks the new rows up without starting over
+    m_count = m_model.size();
+    m_sceneDirty |= SceneRowsAppended;
+    setImplicitHeight(layout().contentHeight());
+    // Before the window is ready, loadAllImages() runs once it is. Rows
+    // streaming in share one scheduling pass per event loop iteration.
+    if (isReadyForTextures()) {
+        requestScheduleLoads();
+    }
+    emit countChanged();
+    emit rowTitlesChanged();
+    update();
+}
+
+void CustomImageListView::onCatalogFinished(bool ok, const QByteArray &data)
+{
+    qDebug() << "Catalog loaded in" << m_catalogClock.elapsed() << "ms," << m_rowTitles.size()
+             << "rows," << m_model.size() << "items";
+    if (!ok) {
+        qWarning() << "Catalog JSON is invalid, keeping the rows parsed before the error";
+    }
+    if (m_catalogDataState == CatalogDataPending) {
+        m_catalogData = data;
+        m_catalogDataState = data.isEmpty() ? CatalogDataFailed : CatalogDataLoaded;
+
+        // Focus may have moved while the bytes were still being parsed
+        const QJsonObject item = sourceJson(m_currentIndex);
+        if (!item.isEmpty()) {
+            emit assetFocused(item);
+        }
+    }
+
+    if (m_model.isEmpty()) {
         qWarning() << "No menu items were loaded!";
         addDefaultItems();
     }
 }
 
+void CustomImageListView::onCatalogSourceRead(const QByteArray &data)
+{
+    if (m_catalogDataState != CatalogDataReading) {
+        return;
+    }
+    m_catalogData = data;
+    m_catalogDataState = data.isEmpty() ? CatalogDataFailed : CatalogDataLoaded;
+
+    // The focus that asked for the bytes, or where it has moved since
+    const QJsonObject item = sourceJson(m_currentIndex);
+    if (!item.isEmpty()) {
+        emit assetFocused(item);
+    }
+}
+
 void CustomImageListView::addDefaultItems()
 {
     qDebug() << "Adding default test items";
     
     m_rowTitles.clear();
     m_rowTitles.append("Test Items");
+    m_rowItemCounts.clear();
+    m_rowItemCounts.append(0);
     
     for (int i = 0; i < 5; i++) {
-        ImageData imgData;
-        imgData.category = "Test Items";
-        imgData.title = QString("Test Item %1").arg(i + 1);
-        imgData.url = QString(":/data/images/img%1.jpg").arg(i % 5 + 1);
-        imgData.id = QString::number(i);
-        m_imageData.append(imgData);
+        CatalogItem item;
+        item.title = QString("Test Item %1").arg(i + 1);
+        item.url = QString(":/data/images/img%1.jpg").arg(i % 5 + 1);
+        item.assetType = QString::number(i);
+        m_model.appendItem(0, item);
+        ++m_rowItemCounts[0];
     }
     
-    m_count = m_imageData.size();
+    m_count = m_model.size();
+    m_layoutDirty = true;
     safeReleaseTextures();
     loadAllImages();
     emit countChanged();
@@ -1922,13 +2296,20 @@ void CustomImageListView::initializeGL()
 }
 
 // Add helper methods for per-category scrolling
-void CustomImageListView::setCategoryContentX(const QString& category, qreal x)
+void CustomImageListView::setCategoryContentX(int row, qreal x)
 {
-    if (m_categoryContentX.value(category, 0.0) != x) {
-        m_categoryContentX[category] = x;
+    if (row < 0) {
+        return;
+    }
+    if (getCategoryContentX(row) != x) {
+        if (row >= m_categoryContentX.size()) {
+            m_categoryContentX.resize(row + 1);
+        }
+        m_categoryContentX[row] = x;
+        m_dirtyRows.insert(row);
         
         // Only trigger visibility check when scrolling the current category
-        if (category == m_currentCategory) {
+        if (row == m_currentRow) {
             handleContentPositionChange();
         }
         
@@ -1936,15 +2317,44 @@ void CustomImageListView::setCategoryContentX(const QString& category, qreal x)
     }
 }
 
-qreal CustomImageListView::getCategoryContentX(const QString& category) const
+const LayoutEngine &CustomImageListView::layout() const
+{
+    // Spacing, dimensions or titles changed, everything is laid out again
+    if (m_layoutDirty || m_layout.rowCount() > m_rowTitles.size()) {
+        m_layout.reset(m_titleHeight, m_rowSpacing);
+        m_layoutDirty = false;
+    }
+    // Rows streaming in are appended below the others. Item indices follow
+    // the row order, each row takes the items that carry its row id. A
+    // row's dimensions are looked up by its title once, here.
+    for (int row = m_layout.rowCount(); row < m_rowTitles.size(); ++row) {
+        const CategoryDimensions dims = getDimensionsForCategory(m_rowTitles[row]);
+        m_layout.appendRow(m_rowItemCounts.value(row), LayoutEngine::RowDimensions{
+            qreal(dims.rowHeight), qreal(dims.posterHeight), qreal(dims.posterWidth), dims.itemSpacing });
+    }
+    return m_layout;
+}
+
+qreal CustomImageListView::rowOriginX(int row) const
+{
+    return m_startPositionX + 10 - getCategoryContentX(row);
+}
+
+int CustomImageListView::indexAt(const QPointF &pos) const
 {
-    return m_categoryContentX.value(category, 0.0);
+    const LayoutEngine &layout = this->layout();
+    const qreal y = pos.y() + m_contentY;
+    const int row = layout.rowAt(y);
+    if (row < 0) {
+        return -1;
+    }
+    return layout.itemAt(row, QPointF(pos.x() - rowOriginX(row), y - layout.rowTop(row)));
 }
 
 void CustomImageListView::updateCurrentCategory()
 {
-    if (m_currentIndex >= 0 && m_currentIndex < m_imageData.size()) {
-        m_currentCategory = m_imageData[m_currentIndex].category;
+    if (m_currentIndex >= 0 && m_currentIndex < m_model.size()) {
+        m_currentRow = m_model.row(m_currentIndex);
     }
 }
 
@@ -1954,70 +2364,75 @@ void CustomImageListView::ensureValidIndex(int &index)
     if (index < 0) {
         index = 0;
     }
-    if (index >= m_imageData.size()) {
-        index = m_imageData.size() - 1;
+    if (index >= m_model.size()) {
+        index = m_model.size() - 1;
     }
 }
 
-// Add in constructor after m_networkManager initialization
-void CustomImageListView::setupNetworkManager()
+// The cache settings live in FetchService, which notifies every view
+bool CustomImageListView::httpCacheEnabled() const
 {
-    if (!m_networkManager) return;
-    
-    // Configure network settings for embedded systems
-    QNetworkConfiguration config;
-    config.setConnectTimeout(30000);  // 30 second timeout
-    m_networkManager->setConfiguration(config);
-    
-    // Enable SSL/HTTPS support
-    #ifndef QT_NO_SSL
-        QSslConfiguration sslConfig = QSslConfiguration::defaultConfiguration();
-        sslConfig.setPeerVerifyMode(QSslSocket::VerifyNone);  // Required for self-signed certs
-        sslConfig.setProtocol(QSsl::TlsV1_0);  // Use TLS 1.0 for maximum compatibility
-        QSslConfiguration::setDefaultConfiguration(sslConfig);
-    #endif
+    return FetchService::instance().isCacheEnabled();
 }
 
-void CustomImageListView::setupScrollAnimation()
+void CustomImageListView::setHttpCacheEnabled(bool enabled)
 {
-    // Create a reusable animation object
-    m_scrollAnimation = new QPropertyAnimation(this);
-    m_scrollAnimation->setDuration(300);  // 300ms duration
-    m_scrollAnimation->setEasingCurve(QEasingCurve::OutCubic);
+    FetchService::instance().setCacheEnabled(enabled);
 }
 
-void CustomImageListView::animateScroll(const QString& category, qreal targetX)
+int CustomImageListView::httpCacheSizeMB() const
 {
-    // Stop any existing animation
-    stopCurrentAnimation();
-    
-    // Create a new animation for this category if it doesn't exist
-    if (!m_categoryAnimations.contains(category)) {
-        QPropertyAnimation* anim = new QPropertyAnimation(this);
-        anim->setDuration(300);
-        anim->setEasingCurve(QEasingCurve::OutCubic);
-        m_categoryAnimations[category] = anim;
-        
-        // Connect animation to update the scroll position
-        connect(anim, &QPropertyAnimation::valueChanged, this, [this, category](const QVariant& value) {
-            setCategoryContentX(category, value.toReal());
-        });
+    return int(FetchService::instance().cacheMaximumSize() / (1024 * 1024));
+}
+
+void CustomImageListView::setHttpCacheSizeMB(int megabytes)
+{
+    FetchService::instance().setCacheMaximumSize(qint64(qMax(0, megabytes)) * 1024 * 1024);
+}
+
+QString CustomImageListView::httpCacheDirectory() const
+{
+    return FetchService::instance().cacheDirectory();
+}
+
+void CustomImageListView::setHttpCacheDirectory(const QString &directory)
+{
+    FetchService::instance().setCacheDirectory(directory);
+}
+
+void CustomImageListView::resetHttpCacheStats()
+{
+    m_httpCacheHits = 0;
+    m_httpCacheMisses = 0;
+    emit httpCacheStatsChanged();
+}
+
+void CustomImageListView::animateScroll(int row, qreal targetX)
+{
+    // The logical position moves right away, the render thread animates
+    // the row's scroll transform from wherever it is on screen
+    setCategoryContentX(row, targetX);
+    if (row >= 0) {
+        m_animatedRows.insert(row);
+        update();
     }
-    
-    QPropertyAnimation* anim = m_categoryAnimations[category];
-    anim->stop();
-    anim->setStartValue(getCategoryContentX(category));
-    anim->setEndValue(targetX);
-    anim->start();
 }
 
-void CustomImageListView::stopCurrentAnimation()
+void CustomImageListView::animateContentY(qreal y)
 {
-    // Stop all category animations
-    for (QPropertyAnimation* anim : m_categoryAnimations.values()) {
-        if (anim->state() == QPropertyAnimation::Running) {
-            anim->stop();
-        }
+    setContentY(y);
+    m_animateContentY = true;
+    update();
+}
+
+void CustomImageListView::setCacheBuffer(qreal buffer)
+{
+    buffer = qMax<qreal>(0, buffer);
+    if (m_cacheBuffer != buffer) {
+        m_cacheBuffer = buffer;
+        m_sceneDirty |= SceneLayoutDirty;
+        emit cacheBufferChanged();
+        update();
     }
 }
 
@@ -2025,6 +2440,7 @@ void CustomImageListView::setStartPositionX(qreal x)
 {
     if (m_startPositionX != x) {
         m_startPositionX = x;
+        m_sceneDirty |= SceneLayoutDirty;
         emit startPositionXChanged();
         update();
     }
@@ -2055,73 +2471,73 @@ void CustomImageListView::handleContentPositionChange()
         return;
     }
     
-    // Update loading priorities based on new visible area
-    QVector<int> visibleIndices = getVisibleIndices();
-    
-    // Prioritize loading visible images first
-    for (int index : visibleIndices) {
-        if (index >= 0 && index < m_imageData.size() && !m_nodes.contains(index)) {
-            // Use a short delay to avoid blocking UI during scrolling
-            QTimer::singleShot(10, this, [this, index]() {
-                if (!m_isBeingDestroyed) {
-                    loadImage(index);
-                }
-            });
-        }
+    // Scrolling changes the position many times in a row
+    requestScheduleLoads();
+}
+
+// Reprioritizes once per event loop pass
+void CustomImageListView::requestScheduleLoads()
+{
+    if (!m_scheduleLoadsPending) {
+        m_scheduleLoadsPending = true;
+        QTimer::singleShot(0, this, [this]() {
+            scheduleLoads();
+        });
     }
 }
 
 // Fix the safeCleanup method - ensuring it's complete
 void CustomImageListView::safeCleanup()
 {
-    // Stop any pending animations
-    if (m_scrollAnimation) {
-        m_scrollAnimation->stop();
-        delete m_scrollAnimation;
-        m_scrollAnimation = nullptr;
-    }
-
-    // Clear category animations
-    qDeleteAll(m_categoryAnimations);
-    m_categoryAnimations.clear();
-
-    // Safely handle network cleanup
-    QList<QNetworkReply*> pendingReplies;
-    
-    // Critical section: only lock while accessing the map
-    {
-        QMutexLocker networkLocker(&m_networkMutex);
-        pendingReplies = m_pendingRequests.values();
-        m_pendingRequests.clear();
-    }
+    // Scroll and focus animations die with the scene graph
+    m_animatedRows.clear();
+    m_animateContentY = false;
 
-    // Now safely abort each reply outside the mutex lock
-    for (QNetworkReply* reply : pendingReplies) {
-        if (reply) {
-            reply->disconnect();  // Disconnect all signals first
-            reply->abort();
-            reply->deleteLater();
-        }
+    // Catalog rows, network replies, decodes and queued loads
+    m_catalogParser->cancel();
+    if (m_catalogDataState == CatalogDataReading) {
+        m_catalogDataState = CatalogDataUnread;
     }
-
-    // Clear URL cache
-    m_urlImageCache.clear();
+    cancelAllLoads();
 
     // Clean up textures
     QMutexLocker locker(&m_loadMutex);
+    QList<QSGTexture*> textures = m_retiredTextures;
     for (auto it = m_nodes.begin(); it != m_nodes.end(); ++it) {
         if (it.value().node) {
             delete it.value().node;
             it.value().node = nullptr;
         }
-        // Don't delete textures here as they belong to the window
+        if (it.value().texture && !textures.contains(it.value().texture)) {
+            textures.append(it.value().texture);
+        }
         it.value().texture = nullptr;
     }
     m_nodes.clear();
+    m_retiredTextures.clear();
+    for (QSGTexture *texture : m_textureResidency.takeAll()) {
+        if (!textures.contains(texture)) {
+            textures.append(texture);
+        }
+    }
+
+    // GL resources have to go away on the render thread
+    if (!textures.isEmpty() || m_posterAtlas) {
+        if (window()) {
+            window()->scheduleRenderJob(new TextureCleanupJob(textures, m_posterAtlas),
+                                        QQuickWindow::NoStage);
+        } else {
+            TextureCleanupJob(textures, m_posterAtlas).run();
+        }
+        m_posterAtlas = nullptr;
+    }
     
     // Clear data
-    m_imageData.clear();
+    m_model.clear();
     m_rowTitles.clear();
+    m_rowItemCounts.clear();
+    m_layoutDirty = true;
     m_categoryContentX.clear();
+    m_sceneDirty |= SceneModelDirty;
 }
 
@@ -13,7 +13,14 @@
 #include <QSGTextureMaterial>
 #include <QSGOpaqueTextureMaterial>
 #include <QSGFlatColorMaterial>
-#include "texturebuffer.h"
+#include "textureresidencymanager.h"
+#include "loadscheduler.h"
+#include "navigationprefetcher.h"
+#include "decodedimagecache.h"
+#include "catalogparser.h"
+#include "catalogsnapshot.h"
+#include "layoutengine.h"
+#include "catalogmodel.h"
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
@@ -21,11 +28,17 @@
 #include <QNetworkRequest>
 #include <QNetworkConfiguration>
 #include <QSslError>
-#include <QPropertyAnimation>  // Add this include
 #include <QSet>  // Add this include
+#include <QAtomicInt>
+#include <QElapsedTimer>
 
 class QSGTexture;
 class QSGGeometry;
+class SwimlaneRootNode;
+class SwimlaneRowNode;
+class TextureAtlas;
+class SwimlaneAnimator;
+class ImageDecoder;
 
 class CustomImageListView : public QQuickItem
 {
@@ -50,33 +63,43 @@ class CustomImageListView : public QQuickItem
     Q_PROPERTY(QStringList rowTitles READ rowTitles WRITE setRowTitles NOTIFY rowTitlesChanged)
     Q_PROPERTY(QUrl jsonSource READ jsonSource WRITE setJsonSource NOTIFY jsonSourceChanged)
     Q_PROPERTY(qreal startPositionX READ startPositionX WRITE setStartPositionX NOTIFY startPositionXChanged)
-    // Q_PROPERTY(int nodeCount READ nodeCount CONSTANT)  // Simplified read-only property
+    Q_PROPERTY(qreal cacheBuffer READ cacheBuffer WRITE setCacheBuffer NOTIFY cacheBufferChanged)
+    Q_PROPERTY(int nodeCount READ nodeCount NOTIFY nodeCountChanged)
+    Q_PROPERTY(int prefetchHits READ prefetchHits NOTIFY prefetchStatsChanged)
+    Q_PROPERTY(int prefetchMisses READ prefetchMisses NOTIFY prefetchStatsChanged)
+    Q_PROPERTY(int prefetchRequests READ prefetchRequests NOTIFY prefetchStatsChanged)
+    Q_PROPERTY(int prefetchLookahead READ prefetchLookahead NOTIFY prefetchStatsChanged)
+    Q_PROPERTY(int imageCacheBudgetMB READ imageCacheBudgetMB WRITE setImageCacheBudgetMB NOTIFY imageCacheBudgetMBChanged)
+    Q_PROPERTY(qreal imageCacheHitRate READ imageCacheHitRate NOTIFY imageCacheStatsChanged)
+    Q_PROPERTY(qreal imageCacheBytes READ imageCacheBytes NOTIFY imageCacheStatsChanged)
+    Q_PROPERTY(int imageCacheEvictions READ imageCacheEvictions NOTIFY imageCacheStatsChanged)
+    Q_PROPERTY(int textureBudgetMB READ textureBudgetMB WRITE setTextureBudgetMB NOTIFY textureBudgetMBChanged)
+    Q_PROPERTY(qreal textureBytes READ textureBytes NOTIFY textureStatsChanged)
+    Q_PROPERTY(int textureEvictions READ textureEvictions NOTIFY textureStatsChanged)
+    Q_PROPERTY(bool httpCacheEnabled READ httpCacheEnabled WRITE setHttpCacheEnabled NOTIFY httpCacheEnabledChanged)
+    Q_PROPERTY(int httpCacheSizeMB READ httpCacheSizeMB WRITE setHttpCacheSizeMB NOTIFY httpCacheSizeMBChanged)
+    Q_PROPERTY(QString httpCacheDirectory READ httpCacheDirectory WRITE setHttpCacheDirectory NOTIFY httpCacheDirectoryChanged)
+    Q_PROPERTY(int httpCacheHits READ httpCacheHits NOTIFY httpCacheStatsChanged)
+    Q_PROPERTY(int httpCacheMisses READ httpCacheMisses NOTIFY httpCacheStatsChanged)
     // Q_PROPERTY(int textureCount READ textureCount CONSTANT)  // Simplified read-only property
     // Q_PROPERTY(bool enableNodeMetrics READ enableNodeMetrics WRITE setEnableNodeMetrics NOTIFY enableNodeMetricsChanged)
     // Q_PROPERTY(bool enableTextureMetrics READ enableTextureMetrics WRITE setEnableTextureMetrics NOTIFY enableTextureMetricsChanged)
 
 private:
-    // Move ImageData struct definition to the top of the private section
-    struct ImageData {
-        QString url;
-        QString title;
-        QString category;
-        QString description;
-        QString id;
-        QString thumbnailUrl;
-        QMap<QString, QString> links;
-        
-        bool operator==(const ImageData& other) const {
-            return url == other.url && 
-                   title == other.title && 
-                   category == other.category && 
-                   id == other.id;
-        }
-    };
-
-    // Now we can use ImageData in member variables
-    QNetworkAccessManager* m_networkManager = nullptr;
-    QVector<ImageData> m_imageData;
+    // Poster replies of this view by where they came from
+    int m_httpCacheHits = 0;
+    int m_httpCacheMisses = 0;
+    // Decodes and scales poster images off the GUI thread
+    ImageDecoder* m_imageDecoder = nullptr;
+    // Streams the menu JSON into rows off the GUI thread
+    CatalogParser* m_catalogParser = nullptr;
+    QElapsedTimer m_catalogClock;
+    // Orders fetches, decodes and uploads by distance to the viewport
+    LoadScheduler* m_loadScheduler = nullptr;
+    // Poster sized images decoded this session, re-uploaded without a decode
+    DecodedImageCache m_decodedImageCache;
+    // Items of all rows, in row order
+    CatalogModel m_model;
     qreal m_startPositionX = 0;  // Add this line for the start position
     int m_count = 15;
     qreal m_itemWidth = 200;
@@ -94,6 +117,8 @@ private:
     qreal m_contentX = 0;
     qreal m_contentY = 0;
     QStringList m_rowTitles;
+    // Items of each row, counted as rows are appended
+    QVector<int> m_rowItemCounts;
     bool m_windowReady = false;
     bool m_isDestroying = false;
     bool m_isLoading = false;
@@ -110,23 +135,21 @@ private:
     void addDefaultItems();  // Add this declaration
     
     // Add helper method declaration for category width calculation
-    qreal categoryContentWidth(const QString& category) const;
+    qreal categoryContentWidth(int row) const;
 
-    // Add new members for per-category scrolling
-    QMap<QString, qreal> m_categoryContentX;
-    QString m_currentCategory;
+    // Horizontal scroll of each row by row id, rows with the same title
+    // scroll on their own; rows never scrolled are at 0
+    QVector<qreal> m_categoryContentX;
+    int m_currentRow = -1;
     
     // Add new helper methods
-    void setCategoryContentX(const QString& category, qreal x);
-    qreal getCategoryContentX(const QString& category) const;
+    void setCategoryContentX(int row, qreal x);
+    qreal getCategoryContentX(int row) const { return m_categoryContentX.value(row); }
     void updateCurrentCategory();
 
     // Add method declaration for index validation
     void ensureValidIndex(int &index);
 
-    // Add network manager setup method declaration
-    void setupNetworkManager();
-
     struct CategoryDimensions {
         int rowHeight;
         int posterHeight;
@@ -136,22 +159,41 @@ private:
     
     QMap<QString, CategoryDimensions> m_categoryDimensions;
     
-    // Helper method to get dimensions for a category
+    // Helper method to get dimensions for a category, only layout() asks,
+    // everything else reads the row's dimensions from the layout
     CategoryDimensions getDimensionsForCategory(const QString& category) const {
         return m_categoryDimensions.value(category, CategoryDimensions{180, 180, 280, 20});
     }
 
-    // Add new member variables
-    QPropertyAnimation* m_scrollAnimation;
-    QMap<QString, QPropertyAnimation*> m_categoryAnimations;
-    
-    // Add helper method declarations
-    void setupScrollAnimation();
-    void animateScroll(const QString& category, qreal targetX);
-    void stopCurrentAnimation();
-
-    // Add member to store complete JSON document
-    QJsonObject m_parsedJson;  // Add this line
+    // Virtualization: margin around the viewport that still gets nodes,
+    // and the number of nodes the render thread last reported
+    qreal m_cacheBuffer = 320;
+    QAtomicInt m_nodeCount;
+
+    // Scroll changes that SwimlaneAnimator should animate on the render
+    // thread instead of jumping, picked up by the next updatePaintNode
+    QSet<int> m_animatedRows;
+    bool m_animateContentY = false;
+    qreal m_syncContentMinY = 0;   // contentY range the animations cover,
+    qreal m_syncContentMaxY = 0;   // only valid during updatePaintNode
+    void animateScroll(int row, qreal targetX);
+    void animateContentY(qreal y);
+
+    // Raw menu JSON, items are parsed out of it by byte range when focused.
+    // After a start from the snapshot it is read on the first focus.
+    enum CatalogDataState {
+        CatalogDataPending,   // comes with the parse
+        CatalogDataUnread,    // rows came from the snapshot, nothing asked yet
+        CatalogDataReading,
+        CatalogDataLoaded,
+        CatalogDataFailed     // not retried per key press
+    };
+    QByteArray m_catalogData;
+    QString m_catalogPath;
+    CatalogDataState m_catalogDataState = CatalogDataPending;
+    void appendCatalogRow(const CatalogRow &row);
+    void catalogRowsAdded();
+    QJsonObject sourceJson(int index);
 
     // Add flag to track destruction state
     bool m_isBeingDestroyed = false;
@@ -282,8 +324,54 @@ public:
     qreal startPositionX() const { return m_startPositionX; }
     void setStartPositionX(qreal x);
 
+    qreal cacheBuffer() const { return m_cacheBuffer; }
+    void setCacheBuffer(qreal buffer);
+
+    int nodeCount() const { return m_nodeCount.load(); }
+
+    // Prefetch tuning: a move that lands on a poster with its texture
+    // ready is a hit, one that shows a placeholder a miss
+    int prefetchHits() const { return m_prefetchHits; }
+    int prefetchMisses() const { return m_prefetchMisses; }
+    int prefetchRequests() const { return m_prefetchRequests; }
+    int prefetchLookahead() const { return m_prefetchLookahead; }
+    Q_INVOKABLE void resetPrefetchStats();
+
+    // In-memory cache of decoded posters, sized per box model
+    int imageCacheBudgetMB() const { return int(m_decodedImageCache.budget() / (1024 * 1024)); }
+    void setImageCacheBudgetMB(int megabytes);
+    qreal imageCacheHitRate() const { return m_decodedImageCache.hitRate(); }
+    qreal imageCacheBytes() const { return qreal(m_decodedImageCache.bytes()); }
+    int imageCacheEvictions() const { return int(m_decodedImageCache.evictions()); }
+    Q_INVOKABLE void resetImageCacheStats();
+
+    // GPU memory held by poster textures
+    int textureBudgetMB() const { return int(m_textureResidency.budget() / (1024 * 1024)); }
+    void setTextureBudgetMB(int megabytes);
+    qreal textureBytes() const { return qreal(m_textureResidency.bytes()); }
+    int textureEvictions() const { return m_textureResidency.evictions(); }
+
+    // HTTP cache for poster fetches. Enabled, responses are cached as their
+    // Cache-Control allows and stale ones are revalidated with
+    // If-None-Match / If-Modified-Since; a 304 is served from the cache.
+    // Disabled, every fetch goes to the network. An empty directory means
+    // the default under the application cache location.
+    // The cache belongs to FetchService and is shared by every view: these
+    // read and write its settings, so setting them on one view changes
+    // them for all and every view notifies.
+    bool httpCacheEnabled() const;
+    void setHttpCacheEnabled(bool enabled);
+    int httpCacheSizeMB() const;
+    void setHttpCacheSizeMB(int megabytes);
+    QString httpCacheDirectory() const;
+    void setHttpCacheDirectory(const QString &directory);
+    // Poster replies served from the cache, revalidated or not, and from
+    // the network
+    int httpCacheHits() const { return m_httpCacheHits; }
+    int httpCacheMisses() const { return m_httpCacheMisses; }
+    Q_INVOKABLE void resetHttpCacheStats();
+
     // // Update accessors to get real-time counts
-    // int nodeCount() const { return m_totalNodeCount; }
     // int textureCount() const { return m_textureCount; }
     
     // bool enableNodeMetrics() const { return m_enableNodeMetrics; }
@@ -326,6 +414,17 @@ signals:
     void startPositionXChanged();
     void moodImageSelected(const QString& url);  // Add this new signal
     void assetFocused(const QJsonObject& assetData);  // Modified to pass complete JSON object
+    void cacheBufferChanged();
+    void nodeCountChanged();
+    void prefetchStatsChanged();
+    void imageCacheBudgetMBChanged();
+    void imageCacheStatsChanged();
+    void textureBudgetMBChanged();
+    void textureStatsChanged();
+    void httpCacheEnabledChanged();
+    void httpCacheSizeMBChanged();
+    void httpCacheDirectoryChanged();
+    void httpCacheStatsChanged();
     // void enableNodeMetricsChanged();
     // void enableTextureMetricsChanged();
 
@@ -340,19 +439,73 @@ protected:
     void wheelEvent(QWheelEvent *event) override;
 
 private:
-    QMutex m_networkMutex;
     // Add OpenGL initialization method
     void initializeGL();
     
-    // Add loadAllImages declaration with other loading-related methods
-    void loadAllImages();
     QString generateImageUrl(int index) const;
     QImage loadLocalImage(int index) const;
-    QImage loadLocalImageFromPath(const QString &path) const;
-    void loadImage(int index);
+    void loadImage(int index, qreal priority);
     void loadUrlImage(int index, const QUrl &url);
-    void handleNetworkReply(QNetworkReply *reply, int index);
     void processLoadedImage(int index, const QImage &image);
+    // Pixel size posters of the item's category are drawn at
+    QSize posterDecodeSize(int index) const;
+    // Flat color a poster shows until its image is uploaded: from the JSON,
+    // else the average of the image when it was loaded before
+    QRgb placeholderColor(int index) const;
+    QHash<QString, QRgb> m_placeholderColors;   // url -> average color
+    // PosterDiskCache entry of the item's image at that size
+    QString diskCacheKey(int index) const;
+    void onImageDecoded(int index, const QImage &image, bool fromDiskCache);
+    void onImageDecodeFailed(int index);
+    // Not in the disk cache, the image is fetched or read and decoded
+    void onDiskCacheMissed(int index);
+
+    // Load scheduling: every item waits in LoadScheduler for the stage it
+    // needs next; the data between stages is parked here
+    QHash<int, QByteArray> m_fetchedData;   // fetched, waiting for a decode slot
+    QHash<int, QImage> m_decodedImages;     // decoded, waiting for an upload slot
+    // Uploads per frame, reset on every sync; the ones over the budget
+    // keep their slot and wait here for the next frame
+    int m_uploadsThisFrame = 0;
+    QList<int> m_deferredUploads;
+    bool m_scheduleLoadsPending = false;
+    void scheduleLoads();
+    void requestScheduleLoads();
+    void startLoad(int index, LoadScheduler::Stage stage);
+    void cancelLoad(int index);
+    void cancelAllLoads();
+    // Poster rect in item coordinates, null for items in no row
+    QRectF itemViewRect(int index) const;
+
+    // Predictive prefetch while navigating: posters the prefetcher expects
+    // focus to reach soon, with the priority they load at. scheduleLoads()
+    // never cancels these however far away they are.
+    NavigationPrefetcher m_prefetcher;
+    QHash<int, qreal> m_prefetchPriorities;
+    int m_prefetchHits = 0;
+    int m_prefetchMisses = 0;
+    int m_prefetchRequests = 0;
+    int m_prefetchLookahead = 0;
+    void onNavigated(NavigationPrefetcher::Direction direction, int previousIndex);
+    void updatePrefetch();
+
+    // Single flight: items with the same image and poster size share one
+    // fetch, one decode and one texture. The first item requesting a key
+    // leads the load through the scheduler, the others wait for it.
+    struct InFlightKey {
+        int leader;
+        QHash<int, qreal> followers;    // waiting index -> its priority
+    };
+    QHash<QString, InFlightKey> m_inFlightKeys;
+    QHash<int, QString> m_inFlightIndexKeys;   // leaders and followers
+    // Uploaded textures by key, refcounted by the items showing them and
+    // evicted farthest first once over budget
+    TextureResidencyManager m_textureResidency;
+    QString loadKey(int index) const;
+    void setItemTexture(int index, QSGTexture *texture);
+    void releaseItemTexture(QSGTexture *texture);
+    void finishInFlightKey(int leader, QSGTexture *texture);
+    void evictTextures();
 
     void debugResourceSystem() const;  // Add this line
     void tryLoadImages();
@@ -362,18 +515,17 @@ private:
     void ensureFocus();  // Add this
     void navigateUp();
     void navigateDown();
+    void navigateToRow(int row);
     void ensureIndexVisible(int index);
 
-    // Remove static texture cache as TextureBuffer handles it
-
-    // Add new members for URL handling
-    QHash<int, QNetworkReply*> m_pendingRequests;
-    QHash<QUrl, QImage> m_urlImageCache;
+    // Running FetchService requests by item and back
+    QHash<int, quint64> m_fetches;
+    QHash<quint64, int> m_fetchIndices;
 
     int getRowFromIndex(int index) const { return index / m_itemsPerRow; }
     int getColumnFromIndex(int index) const { return index % m_itemsPerRow; }
 
-    QSGGeometryNode* createRowTitleNode(const QString &text, const QRectF &rect);
+    QSGGeometryNode* createRowTitleNode(const QString &text, const QRectF &rect, QSGTexture **texture = nullptr);
 
     void createFallbackTexture(int index);  // Add this declaration
     bool isReadyForTextures() const;  // Add this declaration
@@ -394,107 +546,73 @@ private:
     void cleanupNode(TexturedNode& node);
     QMap<int, TexturedNode> m_nodes;
 
-    void limitTextureCacheSize(int maxTextures = 10);
     void safeReleaseTextures();
     bool ensureValidWindow() const;
-    
-    static constexpr int MAX_LOADED_TEXTURES = 10;
 
     void loadFromJson(const QUrl &source);
-    void processJsonData(const QByteArray &data);
-
-    //QVector<ImageData> m_imageData;
 
     // Organize all node creation methods together in one place
-    QSGGeometryNode* createTexturedRect(const QRectF &rect, QSGTexture *texture, bool isFocused = false);
+    QSGGeometryNode* createTexturedRect(const QRectF &rect, QSGTexture *texture);
    // QSGGeometryNode* createRowTitleNode(const QString &text, const QRectF &rect);
-    QSGGeometryNode* createOptimizedTextNode(const QString &text, const QRectF &rect);
-    void addSelectionEffects(QSGNode* container, const QRectF& rect);
-    void addTitleOverlay(QSGNode* container, const QRectF& rect, const QString& title);
-
-    // Add new method declarations
-    void loadUISettings();
 
-    // Add the declaration for calculateItemVerticalPosition
-    qreal calculateItemVerticalPosition(int index);
+    // Retained scene graph: what changed since the last updatePaintNode
+    enum SceneDirtyFlag {
+        SceneModelDirty   = 0x1,  // rows or items changed, rebuild the row nodes
+        SceneLayoutDirty  = 0x2,  // layout changed, reposition everything in every row
+        SceneScrollDirty  = 0x4,  // contentY changed, only move the rows
+        SceneRowsAppended = 0x8   // rows streamed in below the others, add their nodes
+    };
+    int m_sceneDirty = SceneModelDirty;
+    QSet<int> m_dirtyRows;        // rows whose horizontal scroll changed
+    QSet<int> m_dirtyTextures;    // item indices that got a new texture
+    int m_paintedFocusIndex = -1; // focus index currently shown by the scene graph
+
+    void rebuildRowNodes(SwimlaneRootNode *rootNode);
+    void appendRowNodes(SwimlaneRootNode *rootNode);
+    // relayout repositions every poster, otherwise only the row transforms
+    // move and posters entering the materialized range are added
+    void updateRowNode(SwimlaneRowNode *rowNode, qreal rowY, bool relayout, SwimlaneAnimator *animator);
+    // Title, program info and remaining time of the row's materialized
+    // posters, batched into one glyph text node
+    void updateRowText(SwimlaneRowNode *rowNode);
+    // Poster rect in row content coordinates
+    QRectF posterRect(int index) const;
+
+    // Posters are packed into a shared atlas so a row renders in a few batches.
+    // Textures that are replaced or dropped are retired and only deleted on
+    // the render thread, once no node references them anymore.
+    TextureAtlas *m_posterAtlas = nullptr;
+    int m_atlasGeneration = 0;
+    QList<QSGTexture*> m_retiredTextures;
+
+    QSGTexture *createPosterTexture(const QImage &image);
+    void retireTexture(QSGTexture *texture);
+
+    static QVector<CatalogSnapshot::Dimensions> loadUISettings(const QString &path);
+    void applyUISettings(const QVector<CatalogSnapshot::Dimensions> &dimensions);
+
+    // Row and poster geometry, rebuilt on first use after rows, items or
+    // their dimensions changed
+    mutable LayoutEngine m_layout;
+    mutable bool m_layoutDirty = true;
+    const LayoutEngine &layout() const;
+    // Where a row's posters start in item coordinates, after its scroll
+    qreal rowOriginX(int row) const;
+    // Item whose poster is under pos in item coordinates, -1 if none
+    int indexAt(const QPointF &pos) const;
     void handleKeyAction(Qt::Key key);  // Add this helper method
 
 private slots:
-    // Change these from declarations to actual slot definitions
-    void onNetworkReplyFinished() {
-        QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
-        if (!reply) return;
-        
-        int index = -1;
-        
-        // Minimize mutex lock duration - just extract what we need
-        {
-            QMutexLocker locker(&m_networkMutex);
-            index = m_pendingRequests.key(reply, -1);
-            
-            // Remove from pending requests map while under lock
-            if (index != -1) {
-                m_pendingRequests.remove(index);
-            }
-        }
-        
-        // Process the reply outside of mutex lock to avoid deadlocks
-        if (index == -1) {
-            reply->deleteLater();
-            return;
-        }
-
-        if (reply->error() == QNetworkReply::NoError) {
-            QByteArray data = reply->readAll();
-            if (!data.isEmpty()) {
-                QImage image;
-                if (image.loadFromData(data)) {
-                    m_urlImageCache.insert(reply->url(), image);
-                    processLoadedImage(index, image);
-                } else {
-                    createFallbackTexture(index);
-                }
-            } else {
-                createFallbackTexture(index);
-            }
-        } else {
-            createFallbackTexture(index);
-        }
-
-        reply->deleteLater();
-    }
-
-    void onNetworkError(QNetworkReply::NetworkError code) {
-        QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
-        if (!reply) return;
-        
-        int index = -1;
-        
-        // Minimize mutex lock duration
-        {
-            QMutexLocker locker(&m_networkMutex);
-            index = m_pendingRequests.key(reply, -1);
-            if (index != -1) {
-                m_pendingRequests.remove(index);
-            }
-        }
-        
-        // Process outside the lock
-        if (index != -1) {
-            createFallbackTexture(index);
-        }
-    }
-
-    void onDownloadProgress(qint64 bytesReceived, qint64 bytesTotal) {
-        QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
-        if (!reply) return;
-
-        int index = m_pendingRequests.key(reply, -1);
-        if (index != -1) {
-            qDebug() << "Download progress for index" << index << ":"
-                     << bytesReceived << "/" << bytesTotal << "bytes";
-        }
-    }
+    // Also posted from the render thread once the window is ready
+    void loadAllImages();
+    // Posted from the sync, uploads held back by the last frame's budget
+    void uploadDeferred();
+
+    void onFetchFinished(quint64 id, const QByteArray &data, bool fromCache);
+    void onCatalogDimensionsLoaded(const QVector<CatalogSnapshot::Dimensions> &dimensions, bool fromSnapshot);
+    void onCatalogRowParsed(const CatalogRow &row);
+    void onCatalogFinished(bool ok, const QByteArray &data);
+    void onCatalogSourceRead(const QByteArray &data);
 };
 
 #endif // CUSTOMIMAGELISTVIEW_H
@@ -0,0 +1,95 @@
+#include "decodedimagecache.h"
+
+namespace {
+qint64 imageBytes(const QImage &image)
+{
+    return qint64(image.bytesPerLine()) * image.height();
+}
+}
+
+DecodedImageCache::DecodedImageCache(qint64 budgetBytes)
+    : m_useCounter(0)
+    , m_budget(qMax<qint64>(0, budgetBytes))
+    , m_bytes(0)
+    , m_hits(0)
+    , m_misses(0)
+    , m_evictions(0)
+{
+}
+
+QImage DecodedImageCache::find(const QString &key)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        ++m_misses;
+        return QImage();
+    }
+    ++m_hits;
+    m_order.remove(it->lastUsed);
+    it->lastUsed = ++m_useCounter;
+    m_order.insert(it->lastUsed, key);
+    return it->image;
+}
+
+void DecodedImageCache::insert(const QString &key, const QImage &image)
+{
+    remove(key);
+
+    // An image larger than the whole budget would only flush everything else
+    const qint64 size = imageBytes(image);
+    if (image.isNull() || size > m_budget) {
+        return;
+    }
+    trim(m_budget - size);
+
+    const quint64 lastUsed = ++m_useCounter;
+    m_entries.insert(key, Entry{ image, lastUsed });
+    m_order.insert(lastUsed, key);
+    m_bytes += size;
+}
+
+void DecodedImageCache::remove(const QString &key)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return;
+    }
+    m_bytes -= imageBytes(it->image);
+    m_order.remove(it->lastUsed);
+    m_entries.erase(it);
+}
+
+void DecodedImageCache::clear()
+{
+    m_entries.clear();
+    m_order.clear();
+    m_bytes = 0;
+}
+
+void DecodedImageCache::setBudget(qint64 bytes)
+{
+    m_budget = qMax<qint64>(0, bytes);
+    trim(m_budget);
+}
+
+qreal DecodedImageCache::hitRate() const
+{
+    const quint64 lookups = m_hits + m_misses;
+    return lookups ? qreal(m_hits) / lookups : 0;
+}
+
+void DecodedImageCache::resetStats()
+{
+    m_hits = 0;
+    m_misses = 0;
+    m_evictions = 0;
+}
+
+void DecodedImageCache::trim(qint64 budget)
+{
+    while (m_bytes > budget && !m_order.isEmpty()) {
+        const QString key = m_order.first();
+        remove(key);
+        ++m_evictions;
+    }
+}
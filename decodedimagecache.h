@@ -0,0 +1,57 @@
+#ifndef DECODEDIMAGECACHE_H
+#define DECODEDIMAGECACHE_H
+
+#include <QHash>
+#include <QMap>
+#include <QImage>
+#include <QString>
+
+// Poster sized images that were decoded in this session, so posters whose
+// textures were released can be uploaded again without going back to the
+// decoder or the disk.
+//
+// The budget is in bytes of pixel data; once it is exceeded the least
+// recently used images are evicted. Hits, misses and evictions are counted
+// so the budget can be sized per box model. GUI thread only.
+class DecodedImageCache
+{
+public:
+    explicit DecodedImageCache(qint64 budgetBytes);
+
+    // Null on a miss; a hit makes the image the most recently used
+    QImage find(const QString &key);
+    void insert(const QString &key, const QImage &image);
+    void remove(const QString &key);
+    void clear();
+
+    void setBudget(qint64 bytes);
+    qint64 budget() const { return m_budget; }
+
+    qint64 bytes() const { return m_bytes; }
+    int count() const { return m_entries.size(); }
+    quint64 hits() const { return m_hits; }
+    quint64 misses() const { return m_misses; }
+    quint64 evictions() const { return m_evictions; }
+    qreal hitRate() const;
+    void resetStats();
+
+private:
+    struct Entry {
+        QImage image;
+        quint64 lastUsed;
+    };
+
+    void trim(qint64 budget);
+
+    QHash<QString, Entry> m_entries;
+    // Keys by last use, the front is evicted first
+    QMap<quint64, QString> m_order;
+    quint64 m_useCounter;
+    qint64 m_budget;
+    qint64 m_bytes;
+    quint64 m_hits;
+    quint64 m_misses;
+    quint64 m_evictions;
+};
+
+#endif // DECODEDIMAGECACHE_H
@@ -0,0 +1,339 @@
+#include "fetchservice.h"
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QNetworkConfiguration>
+#include <QNetworkDiskCache>
+#include <QStandardPaths>
+#include <QDir>
+#include <QPointer>
+#include <QCoreApplication>
+#include <QDebug>
+
+#ifndef QT_NO_SSL
+#include <QSslConfiguration>
+#include <QSslSocket>
+#endif
+
+namespace {
+// Browsers open six connections per host as well; with HTTP/2 they all
+// share one connection anyway
+const int DEFAULT_MAX_PER_HOST = 6;
+const int WHEEL_TICK_MS = 250;
+// 64 seconds ahead, longer timeouts go round the wheel more than once
+const int WHEEL_SLOTS = 256;
+const qint64 DEFAULT_CACHE_BYTES = 64 * 1024 * 1024;
+}
+
+FetchService& FetchService::instance()
+{
+    // Not a function local static: that would tear the manager down after
+    // the application, possibly with replies in flight
+    static QPointer<FetchService> service;
+    if (!service) {
+        service = new FetchService(QCoreApplication::instance());
+    }
+    return *service;
+}
+
+FetchService::FetchService(QObject *parent)
+    : QObject(parent)
+    , m_nextId(0)
+    , m_maxPerHost(DEFAULT_MAX_PER_HOST)
+    , m_wheel(WHEEL_SLOTS)
+    , m_wheelPosition(0)
+    , m_cache(nullptr)
+    , m_cacheMaximumSize(DEFAULT_CACHE_BYTES)
+{
+    QNetworkConfiguration config;
+    config.setConnectTimeout(30000);
+    m_manager.setConfiguration(config);
+
+#ifndef QT_NO_SSL
+    // Self-signed image hosts are common on the boxes' networks. The
+    // protocol is negotiated, HTTP/2 needs TLS 1.2.
+    QSslConfiguration sslConfig = QSslConfiguration::defaultConfiguration();
+    sslConfig.setPeerVerifyMode(QSslSocket::VerifyNone);
+    sslConfig.setProtocol(QSsl::SecureProtocols);
+    QSslConfiguration::setDefaultConfiguration(sslConfig);
+#endif
+
+    m_wheelTimer.setInterval(WHEEL_TICK_MS);
+    connect(&m_wheelTimer, SIGNAL(timeout()), this, SLOT(onWheelTick()));
+    m_clock.start();
+
+    if (QCoreApplication *app = QCoreApplication::instance()) {
+        connect(app, &QCoreApplication::aboutToQuit, this, &FetchService::onAboutToQuit);
+    }
+
+    setCacheEnabled(true);
+}
+
+// Nobody is left to receive the results
+void FetchService::onAboutToQuit()
+{
+    m_wheelTimer.stop();
+    // Waiting ones first, so cancelling a running one does not start them
+    for (Host &host : m_hosts) {
+        for (quint64 id : host.waiting) {
+            m_requests.remove(id);
+        }
+        host.waiting.clear();
+    }
+    const QList<quint64> ids = m_requests.keys();
+    for (quint64 id : ids) {
+        cancel(id);
+    }
+}
+
+QString FetchService::hostKey(const QUrl &url)
+{
+    return url.scheme() + QLatin1String("://") + url.host() + QLatin1Char(':')
+         + QString::number(url.port(url.scheme() == QLatin1String("https") ? 443 : 80));
+}
+
+quint64 FetchService::get(const QUrl &url, int timeoutMs)
+{
+    const quint64 id = ++m_nextId;
+    Request request = { url, hostKey(url), timeoutMs, 0, nullptr };
+    m_requests.insert(id, request);
+
+    Host &host = m_hosts[request.host];
+    if (host.running < m_maxPerHost) {
+        start(id);
+    } else {
+        host.waiting.append(id);
+    }
+    return id;
+}
+
+void FetchService::start(quint64 id)
+{
+    auto it = m_requests.find(id);
+    if (it == m_requests.end()) {
+        return;
+    }
+
+    QNetworkRequest request(it->url);
+    request.setRawHeader("User-Agent", "Mozilla/5.0 (compatible; Qt/5.6)");
+    request.setRawHeader("Accept", "image/webp,image/apng,image/*,*/*;q=0.8");
+    request.setRawHeader("Connection", "keep-alive");
+    request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+    // PreferNetwork uses fresh cache entries as they are and revalidates
+    // stale ones with a conditional request
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute,
+                         m_cache ? QNetworkRequest::PreferNetwork : QNetworkRequest::AlwaysNetwork);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+    // Negotiated through ALPN, servers without HTTP/2 get HTTP/1.1
+    request.setAttribute(QNetworkRequest::HTTP2AllowedAttribute, true);
+#endif
+
+    QNetworkReply *reply = m_manager.get(request);
+    connect(reply, SIGNAL(finished()), this, SLOT(onReplyFinished()));
+#ifndef QT_NO_SSL
+    connect(reply, SIGNAL(sslErrors(QList<QSslError>)), reply, SLOT(ignoreSslErrors()));
+#endif
+
+    it->reply = reply;
+    m_replies.insert(reply, id);
+    ++m_hosts[it->host].running;
+
+    // The timeout counts from the start, not from the time spent waiting
+    // for a connection slot
+    it->deadline = m_clock.elapsed() + it->timeoutMs;
+    scheduleDeadline(id, it->deadline);
+}
+
+void FetchService::cancel(quint64 id)
+{
+    auto it = m_requests.find(id);
+    if (it == m_requests.end()) {
+        return;
+    }
+    if (!it->reply) {
+        m_hosts[it->host].waiting.removeOne(id);
+        m_requests.erase(it);
+        return;
+    }
+
+    QNetworkReply *reply = it->reply;
+    reply->disconnect(this);
+    release(id);
+    reply->abort();
+    reply->deleteLater();
+}
+
+void FetchService::release(quint64 id)
+{
+    auto it = m_requests.find(id);
+    if (it == m_requests.end()) {
+        return;
+    }
+    const QString host = it->host;
+    // The wheel entry stays and is skipped when its slot comes up
+    m_replies.remove(it->reply);
+    m_requests.erase(it);
+
+    Host &state = m_hosts[host];
+    --state.running;
+    startWaiting(host);
+}
+
+void FetchService::startWaiting(const QString &host)
+{
+    Host &state = m_hosts[host];
+    while (state.running < m_maxPerHost && !state.waiting.isEmpty()) {
+        start(state.waiting.takeFirst());
+    }
+}
+
+void FetchService::onReplyFinished()
+{
+    QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
+    if (!reply) {
+        return;
+    }
+    const quint64 id = m_replies.value(reply);
+    reply->deleteLater();
+    if (!id) {
+        return;
+    }
+
+    QByteArray data;
+    if (reply->error() == QNetworkReply::NoError) {
+        data = reply->readAll();
+    } else if (reply->error() != QNetworkReply::OperationCanceledError) {
+        qDebug() << "Fetch failed" << reply->url().toString() << reply->errorString();
+    }
+    const bool fromCache = reply->attribute(QNetworkRequest::SourceIsFromCacheAttribute).toBool();
+
+    // The slot is free before the listener queues its next request
+    release(id);
+    emit finished(id, data, fromCache);
+}
+
+void FetchService::scheduleDeadline(quint64 id, qint64 deadline)
+{
+    const qint64 ticks = qMax<qint64>(1, (deadline - m_clock.elapsed() + WHEEL_TICK_MS - 1) / WHEEL_TICK_MS);
+    const int slot = (m_wheelPosition + int(qMin<qint64>(ticks, WHEEL_SLOTS - 1))) % WHEEL_SLOTS;
+    m_wheel[slot].append(id);
+    if (!m_wheelTimer.isActive()) {
+        m_wheelTimer.start();
+    }
+}
+
+void FetchService::onWheelTick()
+{
+    m_wheelPosition = (m_wheelPosition + 1) % WHEEL_SLOTS;
+    const QList<quint64> due = m_wheel[m_wheelPosition];
+    m_wheel[m_wheelPosition].clear();
+
+    const qint64 now = m_clock.elapsed();
+    for (quint64 id : due) {
+        auto it = m_requests.constFind(id);
+        if (it == m_requests.constEnd() || !it->reply) {
+            continue;
+        }
+        if (it->deadline > now) {
+            // Beyond the wheel's horizon when scheduled, another round
+            scheduleDeadline(id, it->deadline);
+            continue;
+        }
+        qDebug() << "Fetch timed out" << it->url.toString();
+        // Reported through finished() with OperationCanceledError
+        it->reply->abort();
+    }
+
+    if (m_replies.isEmpty()) {
+        m_wheelTimer.stop();
+        for (QList<quint64> &slot : m_wheel) {
+            slot.clear();
+        }
+    }
+}
+
+void FetchService::prewarm(const QUrl &url)
+{
+    if (url.host().isEmpty()) {
+        return;
+    }
+    const QString key = hostKey(url);
+    if (m_prewarmed.contains(key)) {
+        return;
+    }
+    m_prewarmed.insert(key);
+
+    const quint16 port = quint16(url.port(url.scheme() == QLatin1String("https") ? 443 : 80));
+#ifndef QT_NO_SSL
+    if (url.scheme() == QLatin1String("https")) {
+        m_manager.connectToHostEncrypted(url.host(), port);
+        return;
+    }
+#endif
+    if (url.scheme() == QLatin1String("http")) {
+        m_manager.connectToHost(url.host(), port);
+    }
+}
+
+void FetchService::setMaxRequestsPerHost(int count)
+{
+    count = qMax(1, count);
+    if (m_maxPerHost == count) {
+        return;
+    }
+    m_maxPerHost = count;
+    const QList<QString> hosts = m_hosts.keys();
+    for (const QString &host : hosts) {
+        startWaiting(host);
+    }
+}
+
+void FetchService::setCacheEnabled(bool enabled)
+{
+    if (enabled == isCacheEnabled()) {
+        return;
+    }
+    if (enabled) {
+        m_cache = new QNetworkDiskCache;
+        m_manager.setCache(m_cache);
+        applyCache();
+    } else {
+        // Deletes the cache, its files stay for when it is enabled again
+        m_manager.setCache(nullptr);
+        m_cache = nullptr;
+    }
+    emit cacheSettingsChanged();
+}
+
+void FetchService::setCacheDirectory(const QString &directory)
+{
+    if (m_cacheDirectory != directory) {
+        m_cacheDirectory = directory;
+        applyCache();
+        emit cacheSettingsChanged();
+    }
+}
+
+void FetchService::setCacheMaximumSize(qint64 bytes)
+{
+    bytes = qMax<qint64>(0, bytes);
+    if (m_cacheMaximumSize != bytes) {
+        m_cacheMaximumSize = bytes;
+        applyCache();
+        emit cacheSettingsChanged();
+    }
+}
+
+void FetchService::applyCache()
+{
+    if (!m_cache) {
+        return;
+    }
+    QString directory = m_cacheDirectory;
+    if (directory.isEmpty()) {
+        directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/http";
+    }
+    if (m_cache->cacheDirectory() != QDir(directory).absolutePath() + QLatin1Char('/')) {
+        m_cache->setCacheDirectory(directory);
+    }
+    m_cache->setMaximumCacheSize(m_cacheMaximumSize);
+}
@@ -0,0 +1,119 @@
+#ifndef FETCHSERVICE_H
+#define FETCHSERVICE_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QVector>
+#include <QUrl>
+#include <QByteArray>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QNetworkAccessManager>
+
+class QNetworkReply;
+class QNetworkDiskCache;
+
+// Poster fetches for every CustomImageListView in the process, over one
+// QNetworkAccessManager so connections and the HTTP cache are shared.
+//
+// Requests are capped per host; the ones over the cap wait in the order
+// they came, which is the order the views' load schedulers picked them.
+// HTTP/2 is allowed where Qt supports it, so one connection carries many
+// posters. Connections to the image hosts can be opened ahead of the first
+// request while the catalog is still being parsed.
+//
+// Timeouts run on a single timer wheel instead of a timer per reply: every
+// running request sits in the slot of its deadline and each tick only
+// looks at one slot. Cancelled requests never report back. GUI thread
+// only.
+//
+// The service is a child of the application. Requests still running when
+// the event loop quits are aborted, and the manager is gone before Qt
+// shuts down.
+class FetchService : public QObject
+{
+    Q_OBJECT
+
+public:
+    static FetchService& instance();
+
+    // Queues a GET and returns its id, never 0. finished() reports it
+    // unless it is cancelled first.
+    quint64 get(const QUrl &url, int timeoutMs = 30000);
+    void cancel(quint64 id);
+
+    // Opens a keep-alive connection to the url's host, once per host
+    void prewarm(const QUrl &url);
+
+    void setMaxRequestsPerHost(int count);
+    int maxRequestsPerHost() const { return m_maxPerHost; }
+    int runningCount() const { return m_replies.size(); }
+    int queuedCount() const { return m_requests.size() - m_replies.size(); }
+
+    // HTTP cache; stale entries are revalidated with conditional requests.
+    // An empty directory means the default under the cache location.
+    void setCacheEnabled(bool enabled);
+    bool isCacheEnabled() const { return m_cache != nullptr; }
+    void setCacheDirectory(const QString &directory);
+    QString cacheDirectory() const { return m_cacheDirectory; }
+    void setCacheMaximumSize(qint64 bytes);
+    qint64 cacheMaximumSize() const { return m_cacheMaximumSize; }
+
+signals:
+    // data is empty when the request failed or timed out
+    void finished(quint64 id, const QByteArray &data, bool fromCache);
+    void cacheSettingsChanged();
+
+private slots:
+    void onReplyFinished();
+    void onWheelTick();
+    void onAboutToQuit();
+
+private:
+    struct Request {
+        QUrl url;
+        QString host;
+        int timeoutMs;
+        qint64 deadline;
+        QNetworkReply *reply;
+    };
+
+    struct Host {
+        int running = 0;
+        QList<quint64> waiting;
+    };
+
+    explicit FetchService(QObject *parent);
+    FetchService(const FetchService&) = delete;
+    FetchService& operator=(const FetchService&) = delete;
+
+    static QString hostKey(const QUrl &url);
+    void start(quint64 id);
+    void startWaiting(const QString &host);
+    void release(quint64 id);
+    void scheduleDeadline(quint64 id, qint64 deadline);
+    void applyCache();
+
+    QNetworkAccessManager m_manager;
+    QHash<quint64, Request> m_requests;
+    QHash<QNetworkReply*, quint64> m_replies;
+    QHash<QString, Host> m_hosts;
+    QSet<QString> m_prewarmed;
+    quint64 m_nextId;
+    int m_maxPerHost;
+
+    // Deadline wheel: slot i holds the requests due about i ticks after
+    // the current position
+    QVector<QList<quint64>> m_wheel;
+    int m_wheelPosition;
+    QTimer m_wheelTimer;
+    QElapsedTimer m_clock;
+
+    QNetworkDiskCache *m_cache;     // owned by m_manager
+    QString m_cacheDirectory;
+    qint64 m_cacheMaximumSize;
+};
+
+#endif // FETCHSERVICE_H
@@ -0,0 +1,429 @@
+#include "glyphtext.h"
+#include "textureatlas.h"
+#include <QQuickWindow>
+#include <QSGTexture>
+#include <QSGMaterialShader>
+#include <QOpenGLShaderProgram>
+#include <QTextLayout>
+#include <QFontMetricsF>
+#include <QGlyphRun>
+#include <QRawFont>
+#include <QPainter>
+#include <QDebug>
+#include <cmath>
+#include <cstring>
+
+namespace {
+QFont scaledFont(const QFont &font, qreal dpr)
+{
+    if (dpr == 1.0) {
+        return font;
+    }
+    QFont scaled = font;
+    if (font.pixelSize() > 0) {
+        scaled.setPixelSize(qRound(font.pixelSize() * dpr));
+    } else {
+        scaled.setPointSizeF(font.pointSizeF() * dpr);
+    }
+    return scaled;
+}
+
+QString rawFontKey(const QRawFont &font)
+{
+    return font.familyName() + QLatin1Char('\x1f') + font.styleName()
+         + QLatin1Char('\x1f') + QString::number(font.pixelSize());
+}
+
+const QSGGeometry::AttributeSet &glyphAttributes()
+{
+    static QSGGeometry::Attribute attributes[] = {
+        QSGGeometry::Attribute::create(0, 2, GL_FLOAT, true),
+        QSGGeometry::Attribute::create(1, 2, GL_FLOAT),
+        QSGGeometry::Attribute::create(2, 4, GL_UNSIGNED_BYTE)
+    };
+    static QSGGeometry::AttributeSet set = { 3, 4 * sizeof(float) + 4 * sizeof(unsigned char), attributes };
+    return set;
+}
+
+class GlyphMaterialShader : public QSGMaterialShader
+{
+public:
+    const char *vertexShader() const override
+    {
+        return "attribute highp vec4 vertex;\n"
+               "attribute highp vec2 texCoord;\n"
+               "attribute lowp vec4 color;\n"
+               "uniform highp mat4 matrix;\n"
+               "varying highp vec2 sampleCoord;\n"
+               "varying lowp vec4 vertexColor;\n"
+               "void main() {\n"
+               "    sampleCoord = texCoord;\n"
+               "    vertexColor = color;\n"
+               "    gl_Position = matrix * vertex;\n"
+               "}\n";
+    }
+
+    const char *fragmentShader() const override
+    {
+        // The page stores coverage in alpha, colors are premultiplied
+        return "uniform lowp sampler2D glyphs;\n"
+               "uniform lowp float opacity;\n"
+               "varying highp vec2 sampleCoord;\n"
+               "varying lowp vec4 vertexColor;\n"
+               "void main() {\n"
+               "    gl_FragColor = vertexColor * (texture2D(glyphs, sampleCoord).a * opacity);\n"
+               "}\n";
+    }
+
+    char const *const *attributeNames() const override
+    {
+        static const char *const names[] = { "vertex", "texCoord", "color", nullptr };
+        return names;
+    }
+
+    void updateState(const RenderState &state, QSGMaterial *newMaterial, QSGMaterial *) override
+    {
+        if (state.isMatrixDirty()) {
+            program()->setUniformValue(m_matrixId, state.combinedMatrix());
+        }
+        if (state.isOpacityDirty()) {
+            program()->setUniformValue(m_opacityId, state.opacity());
+        }
+        GlyphMaterial *material = static_cast<GlyphMaterial *>(newMaterial);
+        if (material->texture()) {
+            material->texture()->bind();
+        }
+    }
+
+protected:
+    void initialize() override
+    {
+        m_matrixId = program()->uniformLocation("matrix");
+        m_opacityId = program()->uniformLocation("opacity");
+    }
+
+private:
+    int m_matrixId = -1;
+    int m_opacityId = -1;
+};
+}
+
+// GlyphCache
+
+GlyphCache &GlyphCache::instance()
+{
+    static GlyphCache cache;
+    return cache;
+}
+
+GlyphCache::~GlyphCache()
+{
+    QList<QQuickWindow*> windows = m_windows.keys();
+    for (QQuickWindow *window : windows) {
+        invalidate(window);
+    }
+}
+
+GlyphCache::WindowCache *GlyphCache::cacheFor(QQuickWindow *window)
+{
+    auto it = m_windows.find(window);
+    if (it != m_windows.end()) {
+        return &it.value();
+    }
+
+    WindowCache cache;
+    // One page keeps all text of a window in a single texture, so every
+    // text node can batch with every other one
+    cache.atlas = new TextureAtlas(QSize(GLYPH_PAGE_SIZE, GLYPH_PAGE_SIZE), 1);
+    QImage solid(4, 4, QImage::Format_ARGB32_Premultiplied);
+    solid.fill(Qt::white);
+    cache.solid = cache.atlas->insert(solid);
+
+    // The page dies with the scene graph, like the title cache
+    QObject::connect(window, &QQuickWindow::sceneGraphInvalidated, [this, window]() {
+        invalidate(window);
+    });
+    QObject::connect(window, &QObject::destroyed, [this, window]() {
+        invalidate(window);
+    });
+    return &m_windows.insert(window, cache).value();
+}
+
+const GlyphCache::GlyphEntry &GlyphCache::glyph(WindowCache &cache, const QRawFont &font,
+                                                const QString &fontKey, quint32 index)
+{
+    const QString key = fontKey + QLatin1Char('\x1f') + QString::number(index);
+    auto it = cache.glyphs.constFind(key);
+    if (it != cache.glyphs.constEnd()) {
+        return it.value();
+    }
+
+    GlyphEntry entry;
+    entry.texture = nullptr;
+
+    // Rasterized once per font and glyph, with a transparent border so the
+    // atlas edge padding stays transparent too
+    QRect bounds = font.boundingRect(index).toAlignedRect();
+    if (!bounds.isEmpty()) {
+        bounds.adjust(-1, -1, 1, 1);
+        QImage image(bounds.size(), QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+
+        QGlyphRun run;
+        run.setRawFont(font);
+        run.setGlyphIndexes(QVector<quint32>() << index);
+        run.setPositions(QVector<QPointF>() << QPointF(-bounds.x(), -bounds.y()));
+
+        QPainter painter(&image);
+        painter.setPen(Qt::white);
+        painter.drawGlyphRun(QPointF(0, 0), run);
+        painter.end();
+
+        // The single page never defragments, so the sub rect stays valid
+        if (AtlasTexture *texture = cache.atlas->insert(image)) {
+            entry.texture = texture;
+            entry.bounds = bounds;
+            entry.texRect = texture->normalizedTextureSubRect();
+        } else {
+            qWarning() << "GlyphCache: glyph page full, dropping glyph" << index << "of" << font.familyName();
+        }
+    }
+
+    return cache.glyphs.insert(key, entry).value();
+}
+
+GlyphCache::TextRun GlyphCache::textRun(QQuickWindow *window, const QString &text,
+                                        const QFont &font, qreal maxWidth)
+{
+    if (!window || text.isEmpty()) {
+        return TextRun();
+    }
+
+    const qreal dpr = window->devicePixelRatio();
+    const QString key = text + QLatin1Char('\x1f') + font.key()
+                      + QLatin1Char('\x1f') + QString::number(maxWidth)
+                      + QLatin1Char('\x1f') + QString::number(dpr);
+
+    QMutexLocker locker(&m_mutex);
+    WindowCache *cache = cacheFor(window);
+
+    auto it = cache->runs.constFind(key);
+    if (it != cache->runs.constEnd()) {
+        return it.value();
+    }
+
+    // Shape in device pixels so glyphs land on whole pixels
+    QFont deviceFont = scaledFont(font, dpr);
+    QFontMetricsF metrics(deviceFont);
+    QString shown = maxWidth > 0 ? metrics.elidedText(text, Qt::ElideRight, maxWidth * dpr) : text;
+
+    QTextLayout layout(shown, deviceFont);
+    QTextOption option;
+    option.setWrapMode(QTextOption::NoWrap);
+    layout.setTextOption(option);
+    layout.beginLayout();
+    QTextLine line = layout.createLine();
+    if (line.isValid()) {
+        line.setLineWidth(1e6);
+        line.setPosition(QPointF(0, 0));
+    }
+    layout.endLayout();
+
+    TextRun run;
+    if (line.isValid()) {
+        run.width = line.naturalTextWidth() / dpr;
+        run.height = line.height() / dpr;
+    }
+
+    // Runs also carry the fallback fonts QTextLayout picked per script
+    const QList<QGlyphRun> glyphRuns = layout.glyphRuns();
+    for (const QGlyphRun &glyphRun : glyphRuns) {
+        const QRawFont rawFont = glyphRun.rawFont();
+        const QString fontKey = rawFontKey(rawFont);
+        const QVector<quint32> indexes = glyphRun.glyphIndexes();
+        const QVector<QPointF> positions = glyphRun.positions();
+
+        for (int i = 0; i < indexes.size(); ++i) {
+            const GlyphEntry &entry = glyph(*cache, rawFont, fontKey, indexes[i]);
+            if (!entry.texture) {
+                continue;
+            }
+            QPointF pen(std::round(positions[i].x()), std::round(positions[i].y()));
+            GlyphQuad quad;
+            quad.rect = QRectF((pen.x() + entry.bounds.x()) / dpr,
+                               (pen.y() + entry.bounds.y()) / dpr,
+                               entry.bounds.width() / dpr,
+                               entry.bounds.height() / dpr);
+            quad.texRect = entry.texRect;
+            run.glyphs.append(quad);
+        }
+    }
+
+    // Labels come from a bounded catalog, a full reset is good enough
+    if (cache->runs.size() >= MAX_TEXT_RUNS) {
+        cache->runs.clear();
+    }
+    cache->runs.insert(key, run);
+    return run;
+}
+
+QSGTexture *GlyphCache::pageTexture(QQuickWindow *window)
+{
+    if (!window) {
+        return nullptr;
+    }
+    QMutexLocker locker(&m_mutex);
+    return cacheFor(window)->solid;
+}
+
+QRectF GlyphCache::solidRect(QQuickWindow *window)
+{
+    if (!window) {
+        return QRectF();
+    }
+    QMutexLocker locker(&m_mutex);
+    QSGTexture *solid = cacheFor(window)->solid;
+    if (!solid) {
+        return QRectF();
+    }
+    // Sample the middle of the block so filtering never reaches the edge
+    QPointF center = solid->normalizedTextureSubRect().center();
+    return QRectF(center, QSizeF(0, 0));
+}
+
+int GlyphCache::glyphCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    int count = 0;
+    for (const WindowCache &cache : m_windows) {
+        count += cache.glyphs.size();
+    }
+    return count;
+}
+
+void GlyphCache::invalidate(QQuickWindow *window)
+{
+    // Emitted on the render thread with the context still current
+    QMutexLocker locker(&m_mutex);
+    auto it = m_windows.find(window);
+    if (it == m_windows.end()) {
+        return;
+    }
+    for (const GlyphEntry &entry : it->glyphs) {
+        delete entry.texture;
+    }
+    delete it->solid;
+    delete it->atlas;
+    m_windows.erase(it);
+}
+
+// GlyphMaterial
+
+GlyphMaterial::GlyphMaterial()
+    : m_texture(nullptr)
+{
+    setFlag(Blending, true);
+}
+
+QSGMaterialType *GlyphMaterial::type() const
+{
+    static QSGMaterialType type;
+    return &type;
+}
+
+QSGMaterialShader *GlyphMaterial::createShader() const
+{
+    return new GlyphMaterialShader;
+}
+
+int GlyphMaterial::compare(const QSGMaterial *other) const
+{
+    const GlyphMaterial *material = static_cast<const GlyphMaterial *>(other);
+    int id = m_texture ? m_texture->textureId() : 0;
+    int otherId = material->m_texture ? material->m_texture->textureId() : 0;
+    return id - otherId;
+}
+
+// GlyphTextNode
+
+GlyphTextNode::GlyphTextNode(QSGTexture *pageTexture, const QRectF &solidRect)
+    : m_quadCount(0)
+    , m_solidRect(solidRect)
+    , m_geometry(glyphAttributes(), 0, 0, GL_UNSIGNED_SHORT)
+{
+    m_geometry.setDrawingMode(GL_TRIANGLES);
+    m_material.setTexture(pageTexture);
+    setGeometry(&m_geometry);
+    setMaterial(&m_material);
+}
+
+void GlyphTextNode::clear()
+{
+    m_vertices.resize(0);
+    m_quadCount = 0;
+}
+
+void GlyphTextNode::addRect(const QRectF &rect, const QColor &color)
+{
+    addQuad(rect, m_solidRect, color);
+}
+
+void GlyphTextNode::addText(const GlyphCache::TextRun &run, const QPointF &pos, const QColor &color)
+{
+    for (const GlyphCache::GlyphQuad &quad : run.glyphs) {
+        addQuad(quad.rect.translated(pos), quad.texRect, color);
+    }
+}
+
+void GlyphTextNode::addQuad(const QRectF &rect, const QRectF &texRect, const QColor &color)
+{
+    // 16 bit indices
+    if (m_vertices.size() + 4 > 0xffff) {
+        return;
+    }
+
+    const unsigned char a = color.alpha();
+    const unsigned char r = color.red() * a / 255;
+    const unsigned char g = color.green() * a / 255;
+    const unsigned char b = color.blue() * a / 255;
+
+    Vertex v[4] = {
+        { float(rect.left()), float(rect.top()), float(texRect.left()), float(texRect.top()), r, g, b, a },
+        { float(rect.right()), float(rect.top()), float(texRect.right()), float(texRect.top()), r, g, b, a },
+        { float(rect.left()), float(rect.bottom()), float(texRect.left()), float(texRect.bottom()), r, g, b, a },
+        { float(rect.right()), float(rect.bottom()), float(texRect.right()), float(texRect.bottom()), r, g, b, a }
+    };
+    for (const Vertex &vertex : v) {
+        m_vertices.append(vertex);
+    }
+    ++m_quadCount;
+}
+
+void GlyphTextNode::commit()
+{
+    const int vertexCount = m_vertices.size();
+    const int indexCount = m_quadCount * 6;
+
+    // Scrolling a row without moving its labels should not re-upload them
+    if (m_geometry.vertexCount() == vertexCount
+            && std::memcmp(m_geometry.vertexData(), m_vertices.constData(),
+                           vertexCount * sizeof(Vertex)) == 0) {
+        return;
+    }
+
+    if (m_geometry.vertexCount() != vertexCount) {
+        m_geometry.allocate(vertexCount, indexCount);
+        quint16 *indices = m_geometry.indexDataAsUShort();
+        for (int quad = 0; quad < m_quadCount; ++quad) {
+            const quint16 base = quad * 4;
+            indices[quad * 6 + 0] = base;
+            indices[quad * 6 + 1] = base + 1;
+            indices[quad * 6 + 2] = base + 2;
+            indices[quad * 6 + 3] = base + 1;
+            indices[quad * 6 + 4] = base + 3;
+            indices[quad * 6 + 5] = base + 2;
+        }
+    }
+    std::memcpy(m_geometry.vertexData(), m_vertices.constData(), vertexCount * sizeof(Vertex));
+    markDirty(DirtyGeometry);
+}
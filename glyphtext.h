@@ -0,0 +1,134 @@
+#ifndef GLYPHTEXT_H
+#define GLYPHTEXT_H
+
+#include <QSGGeometryNode>
+#include <QSGGeometry>
+#include <QSGMaterial>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+#include <QString>
+#include <QFont>
+#include <QColor>
+#include <QRectF>
+
+class QQuickWindow;
+class QSGTexture;
+class QRawFont;
+class TextureAtlas;
+
+// Text rendering on top of public API only: strings are shaped with
+// QTextLayout into QRawFont glyph runs, every glyph is rasterized once into a
+// shared per-window glyph page, and text is drawn as textured quads. Shaped
+// strings are cached too, so building text geometry never rasterizes or
+// re-shapes anything in steady state. Must be used on the render thread.
+class GlyphCache
+{
+public:
+    static GlyphCache &instance();
+
+    struct GlyphQuad {
+        QRectF rect;        // Logical pixels relative to the top left of the line
+        QRectF texRect;     // Normalized coordinates on the glyph page
+    };
+
+    struct TextRun {
+        QVector<GlyphQuad> glyphs;
+        qreal width = 0;
+        qreal height = 0;
+    };
+
+    // Shaped single line of text, elided to maxWidth when maxWidth > 0
+    TextRun textRun(QQuickWindow *window, const QString &text, const QFont &font, qreal maxWidth = 0);
+
+    // Any texture on the glyph page, binding it binds the whole page
+    QSGTexture *pageTexture(QQuickWindow *window);
+    // Opaque white texels on the page, for solid quads drawn with text
+    QRectF solidRect(QQuickWindow *window);
+
+    int glyphCount() const;
+
+private:
+    GlyphCache() = default;
+    ~GlyphCache();
+    GlyphCache(const GlyphCache &) = delete;
+    GlyphCache &operator=(const GlyphCache &) = delete;
+
+    struct GlyphEntry {
+        QSGTexture *texture;    // Region on the page, nullptr for blank glyphs
+        QRect bounds;           // Device pixels relative to the pen position
+        QRectF texRect;
+    };
+
+    struct WindowCache {
+        TextureAtlas *atlas;
+        QSGTexture *solid;
+        QHash<QString, GlyphEntry> glyphs;
+        QHash<QString, TextRun> runs;
+    };
+
+    WindowCache *cacheFor(QQuickWindow *window);
+    const GlyphEntry &glyph(WindowCache &cache, const QRawFont &font, const QString &fontKey, quint32 index);
+    void invalidate(QQuickWindow *window);
+
+    QHash<QQuickWindow*, WindowCache> m_windows;
+    mutable QMutex m_mutex;
+
+    static constexpr int GLYPH_PAGE_SIZE = 1024;
+    static constexpr int MAX_TEXT_RUNS = 2048;
+};
+
+// Colored text and solid rectangles from the glyph page in one draw call.
+// Vertices carry their own color so different labels still batch together.
+class GlyphMaterial : public QSGMaterial
+{
+public:
+    GlyphMaterial();
+
+    QSGMaterialType *type() const override;
+    QSGMaterialShader *createShader() const override;
+    int compare(const QSGMaterial *other) const override;
+
+    void setTexture(QSGTexture *texture) { m_texture = texture; }
+    QSGTexture *texture() const { return m_texture; }
+
+private:
+    QSGTexture *m_texture;
+};
+
+// All text of one swimlane row. Call clear(), add the labels, then commit()
+// to upload; unchanged content does not mark the geometry dirty.
+class GlyphTextNode : public QSGGeometryNode
+{
+public:
+    GlyphTextNode(QSGTexture *pageTexture, const QRectF &solidRect);
+
+    void clear();
+    void addRect(const QRectF &rect, const QColor &color);
+    void addText(const GlyphCache::TextRun &run, const QPointF &pos, const QColor &color);
+    void commit();
+
+    int quadCount() const { return m_quadCount; }
+
+private:
+    struct Vertex {
+        float x;
+        float y;
+        float tx;
+        float ty;
+        unsigned char r;
+        unsigned char g;
+        unsigned char b;
+        unsigned char a;
+    };
+
+    void addQuad(const QRectF &rect, const QRectF &texRect, const QColor &color);
+
+    QVector<Vertex> m_vertices;
+    int m_quadCount;
+    QRectF m_solidRect;
+    QSGGeometry m_geometry;
+    GlyphMaterial m_material;
+};
+
+#endif // GLYPHTEXT_H
@@ -0,0 +1,208 @@
+#include "imagedecoder.h"
+#include "posterscaler.h"
+#include "posterdiskcache.h"
+#include <QRunnable>
+#include <QImageReader>
+#include <QBuffer>
+#include <QThread>
+#include <QDebug>
+
+namespace {
+class DecodeJob : public QRunnable
+{
+public:
+    DecodeJob(ImageDecoder *decoder, int index, quint64 ticket,
+              const QSharedPointer<QAtomicInt> &cancelled,
+              const QString &path, const QByteArray &data, const QSize &targetSize,
+              const QString &cacheKey, bool readCache)
+        : m_decoder(decoder)
+        , m_index(index)
+        , m_ticket(ticket)
+        , m_cancelled(cancelled)
+        , m_path(path)
+        , m_data(data)
+        , m_targetSize(targetSize)
+        , m_cacheKey(cacheKey)
+        , m_readCache(readCache)
+    {
+    }
+
+    void run() override
+    {
+        if (m_readCache) {
+            const QImage image = isCancelled() ? QImage() : PosterDiskCache::instance().find(m_cacheKey);
+            finish(image);
+            return;
+        }
+
+        QImage image = decode();
+        // Stored even if cancelled by now, the work is done and the poster
+        // is likely wanted again
+        if (!image.isNull() && !m_cacheKey.isEmpty()) {
+            PosterDiskCache::instance().insert(m_cacheKey, image);
+        }
+        finish(image);
+    }
+
+private:
+    void finish(const QImage &image)
+    {
+        // The decoder waits for the pool before it goes away, and a queued
+        // call to an object deleted in the meantime is dropped by Qt
+        QMetaObject::invokeMethod(m_decoder, "onJobFinished", Qt::QueuedConnection,
+                                  Q_ARG(int, m_index), Q_ARG(quint64, m_ticket),
+                                  Q_ARG(QImage, image), Q_ARG(bool, m_readCache));
+    }
+
+
+    bool isCancelled() const { return m_cancelled->load() != 0; }
+
+    QImage decode()
+    {
+        // Checked between the expensive steps, a cancelled job stops early
+        if (isCancelled()) {
+            return QImage();
+        }
+
+        QBuffer buffer(&m_data);
+        QImageReader reader;
+        if (m_path.isEmpty()) {
+            buffer.open(QIODevice::ReadOnly);
+            reader.setDevice(&buffer);
+        } else {
+            reader.setFileName(m_path);
+        }
+
+        // The header alone gives the size, decode directly at the fitted
+        // size instead of decoding everything and throwing most of it away
+        QSize fitted;
+        const QSize sourceSize = reader.size();
+        if (m_targetSize.isValid() && sourceSize.isValid()) {
+            fitted = sourceSize.scaled(m_targetSize, Qt::KeepAspectRatio);
+            if (fitted.width() < sourceSize.width() && !fitted.isEmpty()) {
+                reader.setScaledSize(fitted);
+            } else {
+                fitted = QSize();
+            }
+        }
+
+        QImage image = reader.read();
+        if (image.isNull()) {
+            qDebug() << "Failed to decode image" << m_index << m_path << reader.errorString();
+            return QImage();
+        }
+        if (isCancelled()) {
+            return QImage();
+        }
+
+        // Whatever the reader could not scale, e.g. formats without a size
+        // in the header, is filtered down in the same pass that converts
+        QSize size;
+        if (!fitted.isValid() && m_targetSize.isValid()) {
+            size = image.size().scaled(m_targetSize, Qt::KeepAspectRatio);
+        }
+        return PosterScaler::scaled(image, size);
+    }
+
+    ImageDecoder *m_decoder;
+    int m_index;
+    quint64 m_ticket;
+    QSharedPointer<QAtomicInt> m_cancelled;
+    QString m_path;
+    QByteArray m_data;
+    QSize m_targetSize;
+    QString m_cacheKey;
+    bool m_readCache;
+};
+
+// Lists the disk cache before the first poster is looked up
+class ScanJob : public QRunnable
+{
+public:
+    void run() override
+    {
+        PosterDiskCache::instance().scan();
+    }
+};
+}
+
+ImageDecoder::ImageDecoder(QObject *parent)
+    : QObject(parent)
+    , m_nextTicket(0)
+{
+    // Leave a core each to the GUI and render threads
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 2));
+    m_pool.start(new ScanJob);
+}
+
+ImageDecoder::~ImageDecoder()
+{
+    cancelAll();
+    m_pool.waitForDone();
+}
+
+void ImageDecoder::decodeFile(int index, const QString &path, const QSize &targetSize,
+                              const QString &cacheKey)
+{
+    start(index, path, QByteArray(), targetSize, cacheKey, false);
+}
+
+void ImageDecoder::decodeData(int index, const QByteArray &data, const QSize &targetSize,
+                              const QString &cacheKey)
+{
+    start(index, QString(), data, targetSize, cacheKey, false);
+}
+
+void ImageDecoder::readCache(int index, const QString &cacheKey)
+{
+    start(index, QString(), QByteArray(), QSize(), cacheKey, true);
+}
+
+void ImageDecoder::start(int index, const QString &path, const QByteArray &data, const QSize &targetSize,
+                         const QString &cacheKey, bool readCache)
+{
+    cancel(index);
+
+    Request request;
+    request.ticket = ++m_nextTicket;
+    request.cancelled = QSharedPointer<QAtomicInt>::create(0);
+    m_inFlight.insert(index, request);
+
+    m_pool.start(new DecodeJob(this, index, request.ticket, request.cancelled,
+                               path, data, targetSize, cacheKey, readCache));
+}
+
+void ImageDecoder::cancel(int index)
+{
+    auto it = m_inFlight.find(index);
+    if (it != m_inFlight.end()) {
+        it->cancelled->store(1);
+        m_inFlight.erase(it);
+    }
+}
+
+void ImageDecoder::cancelAll()
+{
+    for (const Request &request : m_inFlight) {
+        request.cancelled->store(1);
+    }
+    m_inFlight.clear();
+}
+
+void ImageDecoder::onJobFinished(int index, quint64 ticket, const QImage &image, bool fromDiskCache)
+{
+    // Cancelled or superseded by a newer request for the same index
+    auto it = m_inFlight.find(index);
+    if (it == m_inFlight.end() || it->ticket != ticket) {
+        return;
+    }
+    m_inFlight.erase(it);
+
+    if (!image.isNull()) {
+        emit imageDecoded(index, image, fromDiskCache);
+    } else if (fromDiskCache) {
+        emit cacheMissed(index);
+    } else {
+        emit decodeFailed(index);
+    }
+}
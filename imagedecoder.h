@@ -0,0 +1,77 @@
+#ifndef IMAGEDECODER_H
+#define IMAGEDECODER_H
+
+#include <QObject>
+#include <QHash>
+#include <QImage>
+#include <QSize>
+#include <QByteArray>
+#include <QSharedPointer>
+#include <QAtomicInt>
+#include <QThreadPool>
+
+// Decodes poster images on a worker pool so JPEG decoding, format conversion
+// and scaling never block the GUI thread.
+//
+// Requests are keyed by item index. At most one decode is in flight per
+// index: a newer request for the same index cancels the older one, and
+// results that were cancelled or superseded are dropped before they reach
+// the view.
+//
+// Images are decoded straight at the largest size that fits targetSize,
+// never larger than the source. For JPEG, QImageReader::setScaledSize makes
+// libjpeg use its scaled IDCT (1/2, 1/4, 1/8), so a full resolution bitmap
+// never exists. PosterScaler does the rest of the scaling and the format
+// conversion in one pass; the result is premultiplied RGBA8888, ready to be
+// uploaded as is. Results with a cache key are also written to
+// PosterDiskCache from the worker, so the next start skips the decode.
+// Looking an image up in PosterDiskCache runs on the pool as well, a hit
+// is delivered like a decoded image. All public methods and the signals
+// live on the GUI thread.
+class ImageDecoder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ImageDecoder(QObject *parent = nullptr);
+    ~ImageDecoder();
+
+    // Local file or Qt resource
+    void decodeFile(int index, const QString &path, const QSize &targetSize,
+                    const QString &cacheKey = QString());
+    // Encoded bytes, e.g. a finished network reply
+    void decodeData(int index, const QByteArray &data, const QSize &targetSize,
+                    const QString &cacheKey = QString());
+    // The image mapped from PosterDiskCache, cacheMissed() if there is none
+    void readCache(int index, const QString &cacheKey);
+
+    void cancel(int index);
+    void cancelAll();
+
+    bool isPending(int index) const { return m_inFlight.contains(index); }
+    int maxThreadCount() const { return m_pool.maxThreadCount(); }
+    int pendingCount() const { return m_inFlight.size(); }
+
+signals:
+    void imageDecoded(int index, const QImage &image, bool fromDiskCache);
+    void decodeFailed(int index);
+    void cacheMissed(int index);
+
+private slots:
+    void onJobFinished(int index, quint64 ticket, const QImage &image, bool fromDiskCache);
+
+private:
+    struct Request {
+        quint64 ticket;
+        QSharedPointer<QAtomicInt> cancelled;
+    };
+
+    void start(int index, const QString &path, const QByteArray &data, const QSize &targetSize,
+               const QString &cacheKey, bool readCache);
+
+    QThreadPool m_pool;
+    QHash<int, Request> m_inFlight;
+    quint64 m_nextTicket;
+};
+
+#endif // IMAGEDECODER_H
@@ -0,0 +1,112 @@
+#include "layoutengine.h"
+#include <algorithm>
+#include <cmath>
+
+LayoutEngine::LayoutEngine()
+{
+    reset(0, 0);
+}
+
+void LayoutEngine::reset(qreal titleHeight, qreal rowSpacing)
+{
+    m_titleHeight = titleHeight;
+    m_rowSpacing = rowSpacing;
+    m_rowTops.clear();
+    m_rowTops.append(0);
+    m_firstItems.clear();
+    m_firstItems.append(0);
+    m_dimensions.clear();
+}
+
+void LayoutEngine::appendRow(int itemCount, const RowDimensions &dimensions)
+{
+    m_dimensions.append(dimensions);
+    m_rowTops.append(m_rowTops.last() + posterOffset() + dimensions.rowHeight + m_rowSpacing);
+    m_firstItems.append(m_firstItems.last() + qMax(0, itemCount));
+}
+
+int LayoutEngine::rowForItem(int index) const
+{
+    if (index < 0 || index >= itemCount()) {
+        return -1;
+    }
+    // Empty rows share their first index with the next row, upper_bound
+    // skips past them to the row that really holds the item
+    auto it = std::upper_bound(m_firstItems.constBegin(), m_firstItems.constEnd(), index);
+    return int(it - m_firstItems.constBegin()) - 1;
+}
+
+int LayoutEngine::rowAt(qreal y) const
+{
+    if (y < 0 || y >= contentHeight()) {
+        return -1;
+    }
+    auto it = std::upper_bound(m_rowTops.constBegin(), m_rowTops.constEnd(), y);
+    return int(it - m_rowTops.constBegin()) - 1;
+}
+
+int LayoutEngine::column(int index) const
+{
+    const int row = rowForItem(index);
+    return row < 0 ? -1 : index - m_firstItems[row];
+}
+
+qreal LayoutEngine::stride(int row) const
+{
+    return m_dimensions[row].posterWidth + m_dimensions[row].itemSpacing;
+}
+
+qreal LayoutEngine::rowContentWidth(int row) const
+{
+    const int count = itemCount(row);
+    return count > 0 ? count * stride(row) - m_dimensions[row].itemSpacing : 0;
+}
+
+QRectF LayoutEngine::itemRect(int index) const
+{
+    const int row = rowForItem(index);
+    if (row < 0) {
+        return QRectF();
+    }
+    const RowDimensions &dims = m_dimensions[row];
+    return QRectF((index - m_firstItems[row]) * stride(row), posterOffset(),
+                  dims.posterWidth, dims.posterHeight);
+}
+
+bool LayoutEngine::rowRange(qreal top, qreal bottom, int *first, int *last) const
+{
+    // First row ending at or below top, last row starting at or above bottom
+    auto begin = m_rowTops.constBegin();
+    *first = int(std::lower_bound(begin + 1, m_rowTops.constEnd(), top) - (begin + 1));
+    *last = int(std::upper_bound(begin, m_rowTops.constEnd() - 1, bottom) - begin) - 1;
+    return *first <= *last;
+}
+
+bool LayoutEngine::columnRange(int row, qreal left, qreal right, int *first, int *last) const
+{
+    *first = 0;
+    *last = itemCount(row) - 1;
+    const qreal step = stride(row);
+    if (step > 0) {
+        *first = qMax(*first, int(std::ceil((left - m_dimensions[row].posterWidth) / step)));
+        *last = qMin(*last, int(std::floor(right / step)));
+    }
+    return *first <= *last;
+}
+
+int LayoutEngine::itemAt(int row, const QPointF &pos) const
+{
+    if (row < 0 || row >= rowCount() || pos.x() < 0) {
+        return -1;
+    }
+    const RowDimensions &dims = m_dimensions[row];
+    if (pos.y() < posterOffset() || pos.y() >= posterOffset() + dims.posterHeight) {
+        return -1;
+    }
+    const qreal step = stride(row);
+    const int column = step > 0 ? int(pos.x() / step) : 0;
+    if (column >= itemCount(row) || pos.x() - column * step >= dims.posterWidth) {
+        return -1;
+    }
+    return m_firstItems[row] + column;
+}
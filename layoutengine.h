@@ -0,0 +1,85 @@
+#ifndef LAYOUTENGINE_H
+#define LAYOUTENGINE_H
+
+#include <QVector>
+#include <QRectF>
+#include <QPointF>
+
+// Geometry of the swimlanes, built once whenever rows, items or their
+// dimensions change and shared by painting, loading, prefetching,
+// navigation and scrolling.
+//
+// Rows are stacked top to bottom: the title, TITLE_SPACING, the poster
+// band and the row spacing. The items of a row are stored next to each
+// other, so every row owns a range of item indices. Row tops and first
+// item indices are kept as prefix sums: finding the row of an item or of a
+// y position is a binary search, finding the columns of a row inside an x
+// range is arithmetic.
+//
+// y is a content coordinate from the top of the first row, x is relative
+// to the start of a row before it scrolls horizontally.
+class LayoutEngine
+{
+public:
+    struct RowDimensions {
+        qreal rowHeight;
+        qreal posterHeight;
+        qreal posterWidth;
+        qreal itemSpacing;
+    };
+
+    // Between a row title and its posters
+    static const int TITLE_SPACING = 10;
+
+    LayoutEngine();
+
+    // Starts over, rows are then appended top to bottom
+    void reset(qreal titleHeight, qreal rowSpacing);
+    void appendRow(int itemCount, const RowDimensions &dimensions);
+
+    int rowCount() const { return m_dimensions.size(); }
+    int itemCount() const { return m_firstItems.last(); }
+    qreal contentHeight() const { return m_rowTops.last(); }
+
+    // -1 for indices outside every row
+    int rowForItem(int index) const;
+    // Row whose title, posters or spacing cover y, -1 outside the content
+    int rowAt(qreal y) const;
+
+    int firstItem(int row) const { return m_firstItems[row]; }
+    int itemCount(int row) const { return m_firstItems[row + 1] - m_firstItems[row]; }
+    int column(int index) const;
+    const RowDimensions &dimensions(int row) const { return m_dimensions[row]; }
+
+    qreal rowTop(int row) const { return m_rowTops[row]; }
+    qreal rowPitch(int row) const { return m_rowTops[row + 1] - m_rowTops[row]; }
+    // Top of the posters relative to the row top
+    qreal posterOffset() const { return m_titleHeight + TITLE_SPACING; }
+    qreal posterTop(int row) const { return m_rowTops[row] + posterOffset(); }
+    qreal stride(int row) const;
+    // From the left edge of the first poster to the right edge of the last
+    qreal rowContentWidth(int row) const;
+
+    // Poster of an item relative to its row's top and start, null if the
+    // index is in no row
+    QRectF itemRect(int index) const;
+
+    // Rows overlapping [top, bottom], false if there are none
+    bool rowRange(qreal top, qreal bottom, int *first, int *last) const;
+    // Columns of a row whose poster overlaps [left, right]
+    bool columnRange(int row, qreal left, qreal right, int *first, int *last) const;
+
+    // Item whose poster contains pos, relative to the row's top and start;
+    // -1 for titles, gaps and spacing
+    int itemAt(int row, const QPointF &pos) const;
+
+private:
+    qreal m_titleHeight;
+    qreal m_rowSpacing;
+    // rowCount() + 1 entries each, the last one is the total
+    QVector<qreal> m_rowTops;
+    QVector<int> m_firstItems;
+    QVector<RowDimensions> m_dimensions;
+};
+
+#endif // LAYOUTENGINE_H
@@ -0,0 +1,148 @@
+#include "loadscheduler.h"
+#include <QMetaObject>
+
+LoadScheduler::LoadScheduler(QObject *parent)
+    : QObject(parent)
+    , m_nextGeneration(0)
+    , m_dispatchScheduled(false)
+{
+    for (int stage = 0; stage < StageCount; ++stage) {
+        m_limits[stage] = 1;
+    }
+}
+
+void LoadScheduler::setLimit(Stage stage, int limit)
+{
+    m_limits[stage] = qMax(1, limit);
+    scheduleDispatch();
+}
+
+void LoadScheduler::enqueue(int index, Stage stage, qreal priority)
+{
+    auto it = m_waiting.constFind(index);
+    if (it != m_waiting.constEnd() && it->stage == stage && m_priorities.value(index) == priority) {
+        return;
+    }
+    m_priorities.insert(index, priority);
+    push(index, stage);
+    scheduleDispatch();
+}
+
+void LoadScheduler::enqueue(int index, Stage stage)
+{
+    auto it = m_waiting.constFind(index);
+    if (it != m_waiting.constEnd() && it->stage == stage) {
+        return;
+    }
+    push(index, stage);
+    scheduleDispatch();
+}
+
+void LoadScheduler::setPriority(int index, qreal priority)
+{
+    auto priorityIt = m_priorities.find(index);
+    if (priorityIt == m_priorities.end() || *priorityIt == priority) {
+        return;
+    }
+    *priorityIt = priority;
+    auto it = m_waiting.constFind(index);
+    if (it != m_waiting.constEnd()) {
+        push(index, it->stage);
+    }
+}
+
+void LoadScheduler::push(int index, Stage stage)
+{
+    const quint32 generation = ++m_nextGeneration;
+    m_waiting.insert(index, Waiting{ stage, generation });
+
+    std::priority_queue<Entry> &queue = m_queues[stage];
+    queue.push(Entry{ m_priorities.value(index), index, generation });
+
+    // Scrolling back and forth piles up stale entries, rebuild from the
+    // live ones before the heap gets much larger than the queue
+    if (int(queue.size()) > 4 * m_waiting.size() + 64) {
+        for (int s = 0; s < StageCount; ++s) {
+            m_queues[s] = std::priority_queue<Entry>();
+        }
+        for (auto live = m_waiting.constBegin(); live != m_waiting.constEnd(); ++live) {
+            m_queues[live->stage].push(Entry{ m_priorities.value(live.key()), live.key(), live->generation });
+        }
+    }
+}
+
+void LoadScheduler::finished(int index, Stage stage)
+{
+    if (m_running[stage].remove(index)) {
+        scheduleDispatch();
+    }
+}
+
+void LoadScheduler::cancel(int index)
+{
+    bool freed = false;
+    for (int stage = 0; stage < StageCount; ++stage) {
+        freed |= m_running[stage].remove(index);
+    }
+    // The heap entry goes stale and is skipped when it comes up
+    m_waiting.remove(index);
+    m_priorities.remove(index);
+    if (freed) {
+        scheduleDispatch();
+    }
+}
+
+void LoadScheduler::clear()
+{
+    m_waiting.clear();
+    m_priorities.clear();
+    for (int stage = 0; stage < StageCount; ++stage) {
+        m_queues[stage] = std::priority_queue<Entry>();
+        m_running[stage].clear();
+    }
+}
+
+bool LoadScheduler::isRunning(int index) const
+{
+    for (int stage = 0; stage < StageCount; ++stage) {
+        if (m_running[stage].contains(index)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void LoadScheduler::scheduleDispatch()
+{
+    // Coalesces the enqueues of one event loop pass, so a whole batch is
+    // queued before the first slot is handed out
+    if (!m_dispatchScheduled) {
+        m_dispatchScheduled = true;
+        QMetaObject::invokeMethod(this, "dispatch", Qt::QueuedConnection);
+    }
+}
+
+void LoadScheduler::dispatch()
+{
+    m_dispatchScheduled = false;
+
+    for (int s = 0; s < StageCount; ++s) {
+        const Stage stage = Stage(s);
+        std::priority_queue<Entry> &queue = m_queues[stage];
+        while (m_running[stage].size() < m_limits[stage] && !queue.empty()) {
+            const Entry entry = queue.top();
+            queue.pop();
+
+            auto it = m_waiting.find(entry.index);
+            if (it == m_waiting.end() || it->generation != entry.generation) {
+                continue;
+            }
+            m_waiting.erase(it);
+            m_running[stage].insert(entry.index);
+
+            // May enqueue or finish other items right away, which only
+            // pushes to the heaps and schedules another dispatch
+            emit ready(entry.index, stage);
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef LOADSCHEDULER_H
+#define LOADSCHEDULER_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <vector>
+#include <queue>
+
+// Decides which poster image loads run next. Every item waits in the queue
+// of the stage it needs (disk cache read, network fetch, decode or texture
+// upload) ordered by
+// a priority the view computes from the distance to the viewport and the
+// focused item, lower first. Each stage has its own concurrency limit;
+// ready() hands out a slot and the view reports back through finished().
+//
+// Priorities can change at any time, e.g. while scrolling, and items that
+// are no longer wanted are cancelled without running. Everything runs on
+// the GUI thread.
+class LoadScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Stage {
+        DiskCache,
+        Network,
+        Decode,
+        Upload,
+        StageCount
+    };
+
+    explicit LoadScheduler(QObject *parent = nullptr);
+
+    void setLimit(Stage stage, int limit);
+    int limit(Stage stage) const { return m_limits[stage]; }
+
+    // Queues the item for a slot in stage; queuing it again only updates
+    // the priority. Without a priority the item keeps its last one, which
+    // is how it moves on to the next stage.
+    void enqueue(int index, Stage stage, qreal priority);
+    void enqueue(int index, Stage stage);
+    // Also applies to running items once they queue for the next stage
+    void setPriority(int index, qreal priority);
+    // The work started by ready() is done, the slot is free again
+    void finished(int index, Stage stage);
+
+    // Drops the item from its queue and frees its running slots; the
+    // caller aborts whatever it had started
+    void cancel(int index);
+    void clear();
+
+    qreal priority(int index) const { return m_priorities.value(index); }
+    bool isQueued(int index) const { return m_waiting.contains(index); }
+    bool isRunning(int index) const;
+    bool isBusy(int index) const { return isQueued(index) || isRunning(index); }
+    int queuedCount() const { return m_waiting.size(); }
+    int runningCount(Stage stage) const { return m_running[stage].size(); }
+
+signals:
+    // A slot in stage is free for the item, start the work now
+    void ready(int index, LoadScheduler::Stage stage);
+
+private slots:
+    void dispatch();
+
+private:
+    struct Entry {
+        qreal priority;
+        int index;
+        quint32 generation;
+
+        // std::priority_queue pops the largest, so lower priorities compare larger
+        bool operator<(const Entry &other) const { return priority > other.priority; }
+    };
+
+    struct Waiting {
+        Stage stage;
+        quint32 generation;
+    };
+
+    void push(int index, Stage stage);
+    void scheduleDispatch();
+
+    // Stale entries are left in the heaps and skipped when popped, a
+    // priority change just pushes a new entry with a new generation
+    std::priority_queue<Entry> m_queues[StageCount];
+    QHash<int, Waiting> m_waiting;
+    QHash<int, qreal> m_priorities;
+    QSet<int> m_running[StageCount];
+    int m_limits[StageCount];
+    quint32 m_nextGeneration;
+    bool m_dispatchScheduled;
+};
+
+#endif // LOADSCHEDULER_H
@@ -0,0 +1,61 @@
+#include "navigationprefetcher.h"
+#include <QtMath>
+
+namespace {
+// Moves older than this no longer count towards the repeat rate
+const qint64 RATE_WINDOW_MS = 1000;
+const int MAX_TRACKED_MOVES = 8;
+// Fetch far enough ahead to cover what the user reaches in this time,
+// roughly a fetch plus decode on a slow connection
+const qreal LOOKAHEAD_SECONDS = 0.75;
+const int MIN_LOOKAHEAD = 2;
+const int MAX_LOOKAHEAD = 20;
+const int MAX_ROWS_AHEAD = 3;
+}
+
+NavigationPrefetcher::NavigationPrefetcher()
+    : m_direction(None)
+{
+    m_clock.start();
+}
+
+void NavigationPrefetcher::recordMove(Direction direction)
+{
+    const qint64 now = m_clock.elapsed();
+    if (direction != m_direction) {
+        // Turning around starts over, the old speed says nothing
+        m_direction = direction;
+        m_moves.clear();
+    }
+    while (!m_moves.isEmpty() && (now - m_moves.first() > RATE_WINDOW_MS
+                                  || m_moves.size() >= MAX_TRACKED_MOVES)) {
+        m_moves.removeFirst();
+    }
+    m_moves.append(now);
+}
+
+void NavigationPrefetcher::reset()
+{
+    m_direction = None;
+    m_moves.clear();
+}
+
+qreal NavigationPrefetcher::movesPerSecond() const
+{
+    if (m_moves.size() < 2 || m_clock.elapsed() - m_moves.last() > RATE_WINDOW_MS) {
+        return 0;
+    }
+    const qint64 span = qMax<qint64>(1, m_moves.last() - m_moves.first());
+    return (m_moves.size() - 1) * 1000.0 / span;
+}
+
+int NavigationPrefetcher::lookahead() const
+{
+    return qBound(MIN_LOOKAHEAD, MIN_LOOKAHEAD + qCeil(movesPerSecond() * LOOKAHEAD_SECONDS),
+                  MAX_LOOKAHEAD);
+}
+
+int NavigationPrefetcher::rowsAhead() const
+{
+    return qBound(1, 1 + qFloor(movesPerSecond() * LOOKAHEAD_SECONDS), MAX_ROWS_AHEAD);
+}
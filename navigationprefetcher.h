@@ -0,0 +1,45 @@
+#ifndef NAVIGATIONPREFETCHER_H
+#define NAVIGATIONPREFETCHER_H
+
+#include <QElapsedTimer>
+#include <QVector>
+
+// Tracks remote control navigation to predict where focus goes next.
+//
+// Holding an arrow key produces a steady stream of moves in one direction;
+// the faster they come, the further ahead posters have to be fetched to be
+// ready when focus gets there. The view asks for the lookahead after every
+// move and queues the posters in the direction of travel itself.
+class NavigationPrefetcher
+{
+public:
+    enum Direction {
+        None,
+        Left,
+        Right,
+        Up,
+        Down
+    };
+
+    NavigationPrefetcher();
+
+    void recordMove(Direction direction);
+    void reset();
+
+    Direction direction() const { return m_direction; }
+    bool isHorizontal() const { return m_direction == Left || m_direction == Right; }
+    // Key repeat rate in the current direction, 0 after a pause
+    qreal movesPerSecond() const;
+
+    // Posters ahead in the row for left and right moves
+    int lookahead() const;
+    // Rows ahead for up and down moves
+    int rowsAhead() const;
+
+private:
+    QElapsedTimer m_clock;
+    Direction m_direction;
+    QVector<qint64> m_moves;    // recent moves in m_direction, oldest first
+};
+
+#endif // NAVIGATIONPREFETCHER_H
@@ -0,0 +1,262 @@
+#include "posterdiskcache.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVector>
+#include <QDebug>
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <utime.h>
+#endif
+
+namespace {
+const quint32 FILE_MAGIC = 0x52545350;  // "PSTR"
+const quint32 FILE_VERSION = 1;
+const char FILE_SUFFIX[] = "poster";
+// Enough for the posters of a few full catalogs without filling the SD card
+const qint64 DEFAULT_MAX_BYTES = 128 * 1024 * 1024;
+const int MAX_DIMENSION = 8192;
+
+// Native byte order, the cache never leaves the box. 32 bytes keep the
+// pixels behind it aligned for the upload.
+struct FileHeader {
+    quint32 magic;
+    quint32 version;
+    quint32 width;
+    quint32 height;
+    quint32 bytesPerLine;
+    quint32 format;
+    quint32 reserved[2];
+};
+static_assert(sizeof(FileHeader) == 32, "FileHeader must stay 32 bytes");
+
+bool isValid(const FileHeader &header, qint64 fileSize)
+{
+    if (header.magic != FILE_MAGIC || header.version != FILE_VERSION
+        || header.width == 0 || header.height == 0
+        || header.width > quint32(MAX_DIMENSION) || header.height > quint32(MAX_DIMENSION)
+        || header.format == QImage::Format_Invalid || header.format >= QImage::NImageFormats) {
+        return false;
+    }
+    const QImage::Format format = QImage::Format(header.format);
+    const int depth = QImage::toPixelFormat(format).bitsPerPixel();
+    if (depth < 8 || header.bytesPerLine < header.width * quint32(depth / 8)) {
+        return false;
+    }
+    // Catches files cut short, e.g. by a power loss right after the rename
+    return fileSize == qint64(sizeof(FileHeader)) + qint64(header.bytesPerLine) * header.height;
+}
+
+// Runs when the last copy of a mapped image goes away
+void unmapFile(void *file)
+{
+    delete static_cast<QFile *>(file);
+}
+}
+
+PosterDiskCache& PosterDiskCache::instance()
+{
+    static PosterDiskCache cache;
+    return cache;
+}
+
+PosterDiskCache::PosterDiskCache()
+    : m_totalBytes(0)
+    , m_maxBytes(DEFAULT_MAX_BYTES)
+    , m_indexed(false)
+{
+    QString base = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (base.isEmpty()) {
+        base = QDir::tempPath();
+    }
+    m_directory = base + QLatin1String("/posters");
+    QDir().mkpath(m_directory);
+}
+
+QString PosterDiskCache::key(const QString &url, const QSize &size, QImage::Format format)
+{
+    const QString source = url + QLatin1Char('\x1f') + QString::number(size.width())
+                         + QLatin1Char('x') + QString::number(size.height())
+                         + QLatin1Char('\x1f') + QString::number(int(format));
+    return QString::fromLatin1(QCryptographicHash::hash(source.toUtf8(), QCryptographicHash::Sha1).toHex());
+}
+
+QString PosterDiskCache::filePath(const QString &key) const
+{
+    return m_directory + QLatin1Char('/') + key + QLatin1Char('.') + QLatin1String(FILE_SUFFIX);
+}
+
+void PosterDiskCache::ensureIndexed()
+{
+    if (m_indexed) {
+        return;
+    }
+    m_indexed = true;
+
+    const QFileInfoList files = QDir(m_directory).entryInfoList(QDir::Files);
+    for (const QFileInfo &info : files) {
+        if (info.suffix() != QLatin1String(FILE_SUFFIX)) {
+            // Temporary file of a write the process died in
+            QFile::remove(info.absoluteFilePath());
+            continue;
+        }
+        m_entries.insert(info.completeBaseName(),
+                         Entry{ info.size(), info.lastModified().toMSecsSinceEpoch() });
+        m_totalBytes += info.size();
+    }
+    trim();
+}
+
+void PosterDiskCache::scan()
+{
+    QMutexLocker locker(&m_mutex);
+    ensureIndexed();
+}
+
+QImage PosterDiskCache::find(const QString &key)
+{
+    QMutexLocker locker(&m_mutex);
+    ensureIndexed();
+
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return QImage();
+    }
+
+    // The file stays open as long as the mapping is in use, closing it
+    // would unmap the pixels
+    QFile *file = new QFile(filePath(key));
+    FileHeader header;
+    uchar *pixels = nullptr;
+    if (file->open(QIODevice::ReadOnly)
+        && file->read(reinterpret_cast<char *>(&header), sizeof(header)) == qint64(sizeof(header))
+        && isValid(header, file->size())) {
+        pixels = file->map(sizeof(header), qint64(header.bytesPerLine) * header.height);
+    }
+    if (!pixels) {
+        qDebug() << "Dropping unreadable poster cache entry" << file->fileName();
+        delete file;
+        removeEntry(key);
+        return QImage();
+    }
+
+    touch(key, *it);
+    // Read only, anything writing to the image gets its own copy
+    return QImage(const_cast<const uchar *>(pixels), int(header.width), int(header.height),
+                  int(header.bytesPerLine), QImage::Format(header.format), unmapFile, file);
+}
+
+void PosterDiskCache::insert(const QString &key, const QImage &image)
+{
+    if (key.isEmpty() || image.isNull() || image.depth() < 8
+        || image.width() > MAX_DIMENSION || image.height() > MAX_DIMENSION) {
+        return;
+    }
+    {
+        // The first scan removes stale temporary files, it has to be done
+        // before ours exist
+        QMutexLocker locker(&m_mutex);
+        ensureIndexed();
+    }
+
+    // Rows are stored without the padding the image may have
+    const int bytesPerLine = image.width() * (image.depth() / 8);
+    FileHeader header = { FILE_MAGIC, FILE_VERSION, quint32(image.width()), quint32(image.height()),
+                          quint32(bytesPerLine), quint32(image.format()), { 0, 0 } };
+
+    // Written to a temporary file and renamed over the entry on commit
+    QSaveFile file(filePath(key));
+    bool ok = file.open(QIODevice::WriteOnly)
+              && file.write(reinterpret_cast<const char *>(&header), sizeof(header)) == qint64(sizeof(header));
+    for (int y = 0; ok && y < image.height(); ++y) {
+        ok = file.write(reinterpret_cast<const char *>(image.constScanLine(y)), bytesPerLine) == bytesPerLine;
+    }
+    if (!ok || !file.commit()) {
+        qWarning() << "Failed to write poster cache entry" << file.fileName() << file.errorString();
+        return;
+    }
+
+    const qint64 bytes = qint64(sizeof(header)) + qint64(bytesPerLine) * image.height();
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        m_totalBytes -= it->bytes;
+    }
+    m_entries.insert(key, Entry{ bytes, QDateTime::currentMSecsSinceEpoch() });
+    m_totalBytes += bytes;
+    trim();
+}
+
+void PosterDiskCache::setMaxSize(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxBytes = qMax<qint64>(0, bytes);
+    if (m_indexed) {
+        trim();
+    }
+}
+
+qint64 PosterDiskCache::maxSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maxBytes;
+}
+
+qint64 PosterDiskCache::size()
+{
+    QMutexLocker locker(&m_mutex);
+    ensureIndexed();
+    return m_totalBytes;
+}
+
+void PosterDiskCache::touch(const QString &key, Entry &entry)
+{
+    entry.lastUsed = QDateTime::currentMSecsSinceEpoch();
+#ifdef Q_OS_UNIX
+    // The modification time carries the LRU order over to the next start,
+    // a mapped read does not update it
+    ::utime(QFile::encodeName(filePath(key)).constData(), nullptr);
+#else
+    Q_UNUSED(key);
+#endif
+}
+
+void PosterDiskCache::trim()
+{
+    if (m_totalBytes <= m_maxBytes) {
+        return;
+    }
+
+    // Down to 90% so the next few inserts don't each evict again
+    const qint64 target = m_maxBytes - m_maxBytes / 10;
+    QVector<QPair<qint64, QString>> byAge;
+    byAge.reserve(m_entries.size());
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        byAge.append(qMakePair(it->lastUsed, it.key()));
+    }
+    std::sort(byAge.begin(), byAge.end());
+
+    for (const auto &entry : byAge) {
+        if (m_totalBytes <= target) {
+            break;
+        }
+        // Images still mapped from the file keep their pages until released
+        removeEntry(entry.second);
+    }
+}
+
+void PosterDiskCache::removeEntry(const QString &key)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return;
+    }
+    m_totalBytes -= it->bytes;
+    m_entries.erase(it);
+    QFile::remove(filePath(key));
+}
@@ -0,0 +1,69 @@
+#ifndef POSTERDISKCACHE_H
+#define POSTERDISKCACHE_H
+
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QSize>
+#include <QString>
+
+// Persistent cache of posters that are already decoded and scaled, so a
+// cold start uploads them without fetching or decoding anything.
+//
+// Every entry is one file named after a hash of URL, decoded size and pixel
+// format. It holds a small header and the raw pixels in the layout the
+// poster atlas uploads, premultiplied RGBA8888 with tightly packed rows.
+// find() maps the file instead of reading it; the returned image points
+// straight into the mapping, which goes away with the last copy of the
+// image.
+//
+// Files are written through QSaveFile, so a crash leaves either the old
+// state or the complete entry, never a torn one. The total size is capped,
+// least recently used entries go first. All methods are thread safe and
+// touch the disk; entries are looked up and written from the decoder pool,
+// never on the GUI thread.
+class PosterDiskCache
+{
+public:
+    static PosterDiskCache& instance();
+
+    static QString key(const QString &url, const QSize &size, QImage::Format format);
+
+    // Lists the directory once, find() and insert() do it on first use
+    // otherwise. Takes a while for a full cache.
+    void scan();
+
+    // Null if there is no valid entry for key
+    QImage find(const QString &key);
+    void insert(const QString &key, const QImage &image);
+
+    void setMaxSize(qint64 bytes);
+    qint64 maxSize() const;
+    qint64 size();
+    QString directory() const { return m_directory; }
+
+private:
+    struct Entry {
+        qint64 bytes;
+        qint64 lastUsed;    // msecs since epoch
+    };
+
+    PosterDiskCache();
+    PosterDiskCache(const PosterDiskCache&) = delete;
+    PosterDiskCache& operator=(const PosterDiskCache&) = delete;
+
+    QString filePath(const QString &key) const;
+    void ensureIndexed();
+    void touch(const QString &key, Entry &entry);
+    void trim();
+    void removeEntry(const QString &key);
+
+    mutable QMutex m_mutex;
+    QString m_directory;
+    QHash<QString, Entry> m_entries;
+    qint64 m_totalBytes;
+    qint64 m_maxBytes;
+    bool m_indexed;
+};
+
+#endif // POSTERDISKCACHE_H
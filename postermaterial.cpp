@@ -0,0 +1,242 @@
+#include "postermaterial.h"
+#include <QSGTexture>
+#include <QSGMaterialShader>
+#include <QOpenGLShaderProgram>
+#include <QVector4D>
+
+namespace {
+class PosterMaterialShader : public QSGMaterialShader
+{
+public:
+    const char *vertexShader() const override
+    {
+        // Zoom and outset are applied here, the geometry never changes on focus
+        return "attribute highp vec4 pos;\n"
+               "attribute highp vec2 corner;\n"
+               "attribute highp vec2 halfSize;\n"
+               "attribute highp vec4 texRect;\n"
+               "attribute lowp vec4 placeholder;\n"
+               "attribute lowp float reveal;\n"
+               "uniform highp mat4 qt_Matrix;\n"
+               "uniform highp float scale;\n"
+               "uniform highp float outset;\n"
+               "varying highp vec2 local;\n"
+               "varying highp vec2 scaledHalf;\n"
+               "varying highp vec4 sourceRect;\n"
+               "varying lowp vec4 placeholderColor;\n"
+               "varying lowp float revealAmount;\n"
+               "void main() {\n"
+               "    scaledHalf = halfSize * scale;\n"
+               "    placeholderColor = placeholder;\n"
+               "    revealAmount = reveal;\n"
+               "    local = corner * (scaledHalf + outset);\n"
+               "    sourceRect = texRect;\n"
+               "    highp vec2 grow = corner * (halfSize * (scale - 1.0) + outset);\n"
+               "    gl_Position = qt_Matrix * vec4(pos.xy + grow, pos.zw);\n"
+               "}\n";
+    }
+
+    const char *fragmentShader() const override
+    {
+        // local is the distance from the poster center, everything past the
+        // zoomed rect is border first and glow after it
+        return "uniform lowp sampler2D qt_Texture;\n"
+               "uniform lowp float qt_Opacity;\n"
+               "uniform highp float borderWidth;\n"
+               "uniform highp float glowSize;\n"
+               "uniform lowp vec4 borderColor;\n"
+               "uniform lowp vec4 glowColor;\n"
+               "varying highp vec2 local;\n"
+               "varying highp vec2 scaledHalf;\n"
+               "varying highp vec4 sourceRect;\n"
+               "varying lowp vec4 placeholderColor;\n"
+               "varying lowp float revealAmount;\n"
+               "void main() {\n"
+               "    highp vec2 d = abs(local) - scaledHalf;\n"
+               "    highp float dist = length(max(d, 0.0));\n"
+               "    highp vec2 t = clamp(local / scaledHalf * 0.5 + 0.5, 0.0, 1.0);\n"
+               "    lowp vec4 tex = mix(placeholderColor,\n"
+               "                        texture2D(qt_Texture, sourceRect.xy + t * sourceRect.zw),\n"
+               "                        revealAmount);\n"
+               "    lowp float inside = step(max(d.x, d.y), 0.0);\n"
+               "    lowp float border = (1.0 - inside) * step(dist, borderWidth);\n"
+               "    lowp float glow = (1.0 - inside - border)\n"
+               "                    * clamp(1.0 - (dist - borderWidth) / max(glowSize, 0.001), 0.0, 1.0);\n"
+               "    gl_FragColor = (tex * inside + borderColor * border + glowColor * glow) * qt_Opacity;\n"
+               "}\n";
+    }
+
+    char const *const *attributeNames() const override
+    {
+        static const char *const names[] = { "pos", "corner", "halfSize", "texRect",
+                                             "placeholder", "reveal", nullptr };
+        return names;
+    }
+
+    void updateState(const RenderState &state, QSGMaterial *newMaterial, QSGMaterial *oldMaterial) override
+    {
+        if (state.isMatrixDirty()) {
+            program()->setUniformValue(m_matrixId, state.combinedMatrix());
+        }
+        if (state.isOpacityDirty()) {
+            program()->setUniformValue(m_opacityId, state.opacity());
+        }
+
+        PosterMaterial *material = static_cast<PosterMaterial *>(newMaterial);
+        PosterMaterial *previous = static_cast<PosterMaterial *>(oldMaterial);
+        if (!previous || previous->compare(material) != 0) {
+            const FocusStyle &style = material->style();
+            program()->setUniformValue(m_scaleId, GLfloat(material->scale()));
+            program()->setUniformValue(m_outsetId, GLfloat(material->outset()));
+            program()->setUniformValue(m_borderWidthId, GLfloat(material->borderWidth()));
+            program()->setUniformValue(m_glowSizeId, GLfloat(material->glowSize()));
+            program()->setUniformValue(m_borderColorId, premultiplied(style.borderColor));
+            program()->setUniformValue(m_glowColorId, premultiplied(style.glowColor));
+        }
+
+        if (material->texture()) {
+            material->texture()->bind();
+        }
+    }
+
+protected:
+    void initialize() override
+    {
+        m_matrixId = program()->uniformLocation("qt_Matrix");
+        m_opacityId = program()->uniformLocation("qt_Opacity");
+        m_scaleId = program()->uniformLocation("scale");
+        m_outsetId = program()->uniformLocation("outset");
+        m_borderWidthId = program()->uniformLocation("borderWidth");
+        m_glowSizeId = program()->uniformLocation("glowSize");
+        m_borderColorId = program()->uniformLocation("borderColor");
+        m_glowColorId = program()->uniformLocation("glowColor");
+    }
+
+private:
+    static QVector4D premultiplied(const QColor &color)
+    {
+        const float alpha = color.alphaF();
+        return QVector4D(color.redF() * alpha, color.greenF() * alpha, color.blueF() * alpha, alpha);
+    }
+
+    int m_matrixId = -1;
+    int m_opacityId = -1;
+    int m_scaleId = -1;
+    int m_outsetId = -1;
+    int m_borderWidthId = -1;
+    int m_glowSizeId = -1;
+    int m_borderColorId = -1;
+    int m_glowColorId = -1;
+};
+
+int compareReal(qreal a, qreal b)
+{
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+}
+
+PosterMaterial::PosterMaterial()
+    : m_texture(nullptr)
+    , m_focusAmount(0)
+{
+}
+
+QSGMaterialType *PosterMaterial::type() const
+{
+    static QSGMaterialType type;
+    return &type;
+}
+
+QSGMaterialShader *PosterMaterial::createShader() const
+{
+    return new PosterMaterialShader;
+}
+
+int PosterMaterial::compare(const QSGMaterial *other) const
+{
+    const PosterMaterial *material = static_cast<const PosterMaterial *>(other);
+    int id = m_texture ? m_texture->textureId() : 0;
+    int otherId = material->m_texture ? material->m_texture->textureId() : 0;
+    if (id != otherId) {
+        return id - otherId;
+    }
+    if (int diff = compareReal(m_focusAmount, material->m_focusAmount)) {
+        return diff;
+    }
+    if (m_focusAmount <= 0) {
+        // The style is not used while unfocused
+        return 0;
+    }
+    if (int diff = compareReal(m_style.scale, material->m_style.scale)) {
+        return diff;
+    }
+    if (int diff = compareReal(m_style.borderWidth, material->m_style.borderWidth)) {
+        return diff;
+    }
+    if (int diff = compareReal(m_style.glowSize, material->m_style.glowSize)) {
+        return diff;
+    }
+    if (m_style.borderColor != material->m_style.borderColor) {
+        return m_style.borderColor.rgba() < material->m_style.borderColor.rgba() ? -1 : 1;
+    }
+    if (m_style.glowColor != material->m_style.glowColor) {
+        return m_style.glowColor.rgba() < material->m_style.glowColor.rgba() ? -1 : 1;
+    }
+    return 0;
+}
+
+void PosterMaterial::setFocused(bool focused, const FocusStyle &style)
+{
+    setFocusAmount(focused ? 1.0 : 0.0, style);
+}
+
+void PosterMaterial::setFocusAmount(qreal amount, const FocusStyle &style)
+{
+    m_focusAmount = qBound<qreal>(0, amount, 1);
+    m_style = style;
+    // Only the glow is translucent, posters and the border stay in the
+    // opaque pass
+    setFlag(Blending, m_focusAmount > 0 && style.glowSize > 0);
+}
+
+const QSGGeometry::AttributeSet &PosterMaterial::attributes()
+{
+    static QSGGeometry::Attribute data[] = {
+        QSGGeometry::Attribute::create(0, 2, GL_FLOAT, true),
+        QSGGeometry::Attribute::create(1, 2, GL_FLOAT),
+        QSGGeometry::Attribute::create(2, 2, GL_FLOAT),
+        QSGGeometry::Attribute::create(3, 4, GL_FLOAT),
+        // Unsigned bytes are normalized by the renderer
+        QSGGeometry::Attribute::create(4, 4, GL_UNSIGNED_BYTE),
+        QSGGeometry::Attribute::create(5, 1, GL_FLOAT)
+    };
+    static QSGGeometry::AttributeSet set = { 6, sizeof(Vertex), data };
+    return set;
+}
+
+void PosterMaterial::updateGeometry(QSGGeometry *geometry, const QRectF &rect, const QRectF &sourceRect,
+                                    QRgb placeholder, qreal reveal)
+{
+    const float halfWidth = rect.width() / 2;
+    const float halfHeight = rect.height() / 2;
+    const float tx = sourceRect.x();
+    const float ty = sourceRect.y();
+    const float tw = sourceRect.width();
+    const float th = sourceRect.height();
+    const QRgb color = qPremultiply(placeholder);
+    const uchar r = uchar(qRed(color));
+    const uchar g = uchar(qGreen(color));
+    const uchar b = uchar(qBlue(color));
+    const uchar a = uchar(qAlpha(color));
+    const float amount = float(qBound<qreal>(0, reveal, 1));
+
+    Vertex *vertices = static_cast<Vertex *>(geometry->vertexData());
+    vertices[0] = { float(rect.left()), float(rect.top()), -1, -1, halfWidth, halfHeight, tx, ty, tw, th,
+                    r, g, b, a, amount };
+    vertices[1] = { float(rect.right()), float(rect.top()), 1, -1, halfWidth, halfHeight, tx, ty, tw, th,
+                    r, g, b, a, amount };
+    vertices[2] = { float(rect.left()), float(rect.bottom()), -1, 1, halfWidth, halfHeight, tx, ty, tw, th,
+                    r, g, b, a, amount };
+    vertices[3] = { float(rect.right()), float(rect.bottom()), 1, 1, halfWidth, halfHeight, tx, ty, tw, th,
+                    r, g, b, a, amount };
+}
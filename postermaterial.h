@@ -0,0 +1,90 @@
+#ifndef POSTERMATERIAL_H
+#define POSTERMATERIAL_H
+
+#include <QSGMaterial>
+#include <QSGGeometry>
+#include <QColor>
+#include <QRectF>
+#include <QRgb>
+
+class QSGTexture;
+
+// How the focused poster is drawn: zoom around the center, a solid border
+// and an optional glow fading out around it. Widths are in logical pixels.
+struct FocusStyle
+{
+    qreal scale = 1.1;
+    qreal borderWidth = 2;
+    QColor borderColor = Qt::white;
+    qreal glowSize = 0;
+    QColor glowColor = QColor(255, 255, 255, 96);
+};
+
+// Poster quad whose focus zoom, border and glow are applied in the shader.
+// The geometry always holds the unfocused rect, so moving focus only changes
+// material state on two nodes. Unfocused posters share equal materials and
+// batch; the focused one draws on its own.
+//
+// Until its image is there a poster shows a flat placeholder color, and
+// the image crossfades in over it. Both live in the vertices rather than
+// in uniforms so posters in any state of the fade still batch.
+class PosterMaterial : public QSGMaterial
+{
+public:
+    PosterMaterial();
+
+    QSGMaterialType *type() const override;
+    QSGMaterialShader *createShader() const override;
+    int compare(const QSGMaterial *other) const override;
+
+    void setTexture(QSGTexture *texture) { m_texture = texture; }
+    QSGTexture *texture() const { return m_texture; }
+
+    // Switches between the plain opaque poster and the focus look
+    void setFocused(bool focused, const FocusStyle &style = FocusStyle());
+    // 0 is unfocused, 1 fully focused; in between zoom, border and glow
+    // are interpolated, which is how focus changes are animated
+    void setFocusAmount(qreal amount, const FocusStyle &style = FocusStyle());
+    bool isFocused() const { return m_focusAmount > 0; }
+    qreal focusAmount() const { return m_focusAmount; }
+
+    qreal scale() const { return 1.0 + (m_style.scale - 1.0) * m_focusAmount; }
+    qreal borderWidth() const { return m_style.borderWidth * m_focusAmount; }
+    qreal glowSize() const { return m_style.glowSize * m_focusAmount; }
+    // How far the quad grows past the zoomed rect for border and glow
+    qreal outset() const { return borderWidth() + glowSize(); }
+    const FocusStyle &style() const { return m_style; }
+
+    // pos (2), corner (2), halfSize (2), texRect (4), placeholder (4 bytes),
+    // reveal (1)
+    static const QSGGeometry::AttributeSet &attributes();
+
+    struct Vertex {
+        float x;
+        float y;
+        float cornerX;      // -1 left, +1 right
+        float cornerY;      // -1 top, +1 bottom
+        float halfWidth;
+        float halfHeight;
+        float tx;
+        float ty;
+        float tw;
+        float th;
+        uchar r;            // placeholder color, premultiplied
+        uchar g;
+        uchar b;
+        uchar a;
+        float reveal;       // 0 placeholder only, 1 image only
+    };
+
+    // Writes the unfocused rect into a 4 vertex triangle strip
+    static void updateGeometry(QSGGeometry *geometry, const QRectF &rect, const QRectF &sourceRect,
+                               QRgb placeholder, qreal reveal);
+
+private:
+    QSGTexture *m_texture;
+    qreal m_focusAmount;
+    FocusStyle m_style;
+};
+
+#endif // POSTERMATERIAL_H
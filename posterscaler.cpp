@@ -0,0 +1,389 @@
+#include "posterscaler.h"
+#include <QVector>
+#include <QtEndian>
+#include <cmath>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+// Compiled per function with target attributes and picked at runtime, so
+// the binary still runs on x86 boxes without AVX2
+#define POSTERSCALER_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+// linux-rasp-pi-* builds with -mfpu=neon-vfpv4
+#define POSTERSCALER_NEON
+#include <arm_neon.h>
+#endif
+
+namespace {
+// Filter weights are fixed point and sum to exactly 1 per axis. Vertical
+// sums stay below 2^20 and the horizontal ones below 2^32.
+const int WEIGHT_BITS = 12;
+const quint32 WEIGHT_ONE = 1u << WEIGHT_BITS;
+const int RESULT_SHIFT = 2 * WEIGHT_BITS;
+
+// Byte offsets of the channels inside one source pixel, a is -1 when opaque
+struct Layout {
+    int bpp;
+    int r;
+    int g;
+    int b;
+    int a;
+};
+
+// Source pixels [first, first + count) with weights[offset...] make up one
+// output pixel along an axis
+struct Tap {
+    int first;
+    int count;
+    int offset;
+};
+
+struct Taps {
+    QVector<Tap> taps;
+    QVector<quint32> weights;
+};
+
+// acc[i] += src[i] * weight for every byte of a source row
+typedef void (*AccumulateFn)(quint32 *acc, const uchar *src, int count, quint32 weight);
+// BGRA or RGBA with the first and third byte swapped, same size conversion
+typedef void (*SwizzleFn)(uchar *dst, const uchar *src, int pixels);
+
+void accumulateScalar(quint32 *acc, const uchar *src, int count, quint32 weight)
+{
+    for (int i = 0; i < count; ++i) {
+        acc[i] += src[i] * weight;
+    }
+}
+
+void swizzleScalar(uchar *dst, const uchar *src, int pixels)
+{
+    for (int i = 0; i < pixels; ++i, src += 4, dst += 4) {
+        dst[0] = src[2];
+        dst[1] = src[1];
+        dst[2] = src[0];
+        dst[3] = src[3];
+    }
+}
+
+#ifdef POSTERSCALER_X86
+__attribute__((target("sse4.1")))
+void accumulateSse41(quint32 *acc, const uchar *src, int count, quint32 weight)
+{
+    const __m128i w = _mm_set1_epi32(int(weight));
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        for (int part = 0; part < 4; ++part) {
+            __m128i *target = reinterpret_cast<__m128i *>(acc + i + part * 4);
+            const __m128i shifted = part == 0 ? bytes
+                                  : part == 1 ? _mm_srli_si128(bytes, 4)
+                                  : part == 2 ? _mm_srli_si128(bytes, 8)
+                                              : _mm_srli_si128(bytes, 12);
+            const __m128i product = _mm_mullo_epi32(_mm_cvtepu8_epi32(shifted), w);
+            _mm_storeu_si128(target, _mm_add_epi32(_mm_loadu_si128(target), product));
+        }
+    }
+    accumulateScalar(acc + i, src + i, count - i, weight);
+}
+
+__attribute__((target("sse4.1")))
+void swizzleSse41(uchar *dst, const uchar *src, int pixels)
+{
+    const __m128i mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    int i = 0;
+    for (; i + 4 <= pixels; i += 4) {
+        const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), _mm_shuffle_epi8(p, mask));
+    }
+    swizzleScalar(dst + i * 4, src + i * 4, pixels - i);
+}
+
+__attribute__((target("avx2")))
+void accumulateAvx2(quint32 *acc, const uchar *src, int count, quint32 weight)
+{
+    const __m256i w = _mm256_set1_epi32(int(weight));
+    int i = 0;
+    for (; i + 32 <= count; i += 32) {
+        for (int part = 0; part < 4; ++part) {
+            __m256i *target = reinterpret_cast<__m256i *>(acc + i + part * 8);
+            const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i + part * 8));
+            const __m256i product = _mm256_mullo_epi32(_mm256_cvtepu8_epi32(bytes), w);
+            _mm256_storeu_si256(target, _mm256_add_epi32(_mm256_loadu_si256(target), product));
+        }
+    }
+    accumulateSse41(acc + i, src + i, count - i, weight);
+}
+
+__attribute__((target("avx2")))
+void swizzleAvx2(uchar *dst, const uchar *src, int pixels)
+{
+    const __m256i mask = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                          2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    int i = 0;
+    for (; i + 8 <= pixels; i += 8) {
+        const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 4), _mm256_shuffle_epi8(p, mask));
+    }
+    swizzleSse41(dst + i * 4, src + i * 4, pixels - i);
+}
+#endif
+
+#ifdef POSTERSCALER_NEON
+void accumulateNeon(quint32 *acc, const uchar *src, int count, quint32 weight)
+{
+    // Weights never exceed WEIGHT_ONE, so they fit the 16 bit multiply
+    const uint16_t w = uint16_t(weight);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const uint16x8_t bytes = vmovl_u8(vld1_u8(src + i));
+        vst1q_u32(acc + i, vmlal_n_u16(vld1q_u32(acc + i), vget_low_u16(bytes), w));
+        vst1q_u32(acc + i + 4, vmlal_n_u16(vld1q_u32(acc + i + 4), vget_high_u16(bytes), w));
+    }
+    accumulateScalar(acc + i, src + i, count - i, weight);
+}
+
+void swizzleNeon(uchar *dst, const uchar *src, int pixels)
+{
+    int i = 0;
+    for (; i + 16 <= pixels; i += 16) {
+        uint8x16x4_t p = vld4q_u8(src + i * 4);
+        const uint8x16_t first = p.val[0];
+        p.val[0] = p.val[2];
+        p.val[2] = first;
+        vst4q_u8(dst + i * 4, p);
+    }
+    swizzleScalar(dst + i * 4, src + i * 4, pixels - i);
+}
+#endif
+
+struct Kernels {
+    AccumulateFn accumulate;
+    SwizzleFn swizzle;
+};
+
+Kernels kernelsFor(PosterScaler::Kernel kernel)
+{
+    switch (kernel) {
+#ifdef POSTERSCALER_X86
+    case PosterScaler::Sse41:
+        return Kernels{ accumulateSse41, swizzleSse41 };
+    case PosterScaler::Avx2:
+        return Kernels{ accumulateAvx2, swizzleAvx2 };
+#endif
+#ifdef POSTERSCALER_NEON
+    case PosterScaler::Neon:
+        return Kernels{ accumulateNeon, swizzleNeon };
+#endif
+    default:
+        return Kernels{ accumulateScalar, swizzleScalar };
+    }
+}
+
+// Area average weights mapping sourceSize pixels onto targetSize
+Taps computeTaps(int sourceSize, int targetSize)
+{
+    Taps result;
+    result.taps.reserve(targetSize);
+    const double ratio = double(sourceSize) / targetSize;
+    for (int i = 0; i < targetSize; ++i) {
+        const double start = i * ratio;
+        const double end = qMin(double(sourceSize), (i + 1) * ratio);
+        Tap tap;
+        tap.first = qMin(sourceSize - 1, int(start));
+        tap.offset = result.weights.size();
+        tap.count = 0;
+
+        quint32 sum = 0;
+        int largest = tap.offset;
+        for (int j = tap.first; j < end; ++j) {
+            const double coverage = qMin(end, j + 1.0) - qMax(start, double(j));
+            const quint32 weight = quint32(coverage / ratio * WEIGHT_ONE + 0.5);
+            if (weight == 0 && tap.count > 0) {
+                continue;
+            }
+            result.weights.append(weight);
+            if (weight > result.weights.at(largest)) {
+                largest = result.weights.size() - 1;
+            }
+            sum += weight;
+            ++tap.count;
+        }
+        // Rounding must not brighten or darken the image
+        result.weights[largest] += WEIGHT_ONE - sum;
+        result.taps.append(tap);
+    }
+    return result;
+}
+
+// Brings any source into one of the layouts the kernels read directly
+QImage normalizedSource(const QImage &source, Layout *layout)
+{
+    const bool littleEndian = Q_BYTE_ORDER == Q_LITTLE_ENDIAN;
+    switch (source.format()) {
+    case QImage::Format_RGB32:
+        *layout = littleEndian ? Layout{ 4, 2, 1, 0, -1 } : Layout{ 4, 1, 2, 3, -1 };
+        return source;
+    case QImage::Format_ARGB32_Premultiplied:
+        *layout = littleEndian ? Layout{ 4, 2, 1, 0, 3 } : Layout{ 4, 1, 2, 3, 0 };
+        return source;
+    case QImage::Format_RGBX8888:
+        *layout = Layout{ 4, 0, 1, 2, -1 };
+        return source;
+    case QImage::Format_RGBA8888_Premultiplied:
+        *layout = Layout{ 4, 0, 1, 2, 3 };
+        return source;
+    case QImage::Format_RGB888:
+        *layout = Layout{ 3, 0, 1, 2, -1 };
+        return source;
+    default:
+        // Grayscale, indexed and straight alpha; averaging needs
+        // premultiplied colors
+        return normalizedSource(source.convertToFormat(source.hasAlphaChannel()
+                                                       ? QImage::Format_ARGB32_Premultiplied
+                                                       : QImage::Format_RGB32), layout);
+    }
+}
+
+void convertRow(uchar *dst, const uchar *src, int width, const Layout &layout, const Kernels &kernels)
+{
+    if (layout.bpp == 4 && layout.r == 2 && layout.g == 1 && layout.b == 0) {
+        // RGB32 keeps 0xff in its unused byte, so it swizzles like ARGB32
+        kernels.swizzle(dst, src, width);
+        return;
+    }
+    if (layout.bpp == 4 && layout.r == 0 && layout.g == 1 && layout.b == 2) {
+        // RGBX8888 keeps 0xff in its unused byte too
+        std::memcpy(dst, src, width * 4);
+        return;
+    }
+    for (int x = 0; x < width; ++x, src += layout.bpp, dst += 4) {
+        dst[0] = src[layout.r];
+        dst[1] = src[layout.g];
+        dst[2] = src[layout.b];
+        dst[3] = layout.a < 0 ? 0xff : src[layout.a];
+    }
+}
+
+// Filters one accumulated row horizontally and writes RGBA8888
+void resolveRow(uchar *dst, const quint32 *acc, const Taps &columns, const Layout &layout)
+{
+    const quint32 half = 1u << (RESULT_SHIFT - 1);
+    const quint32 *weights = columns.weights.constData();
+    for (const Tap &tap : columns.taps) {
+        const quint32 *pixel = acc + tap.first * layout.bpp;
+        quint32 r = half;
+        quint32 g = half;
+        quint32 b = half;
+        quint32 a = half;
+        for (int k = 0; k < tap.count; ++k, pixel += layout.bpp) {
+            const quint32 weight = weights[tap.offset + k];
+            r += pixel[layout.r] * weight;
+            g += pixel[layout.g] * weight;
+            b += pixel[layout.b] * weight;
+            if (layout.a >= 0) {
+                a += pixel[layout.a] * weight;
+            }
+        }
+        dst[0] = uchar(r >> RESULT_SHIFT);
+        dst[1] = uchar(g >> RESULT_SHIFT);
+        dst[2] = uchar(b >> RESULT_SHIFT);
+        dst[3] = layout.a >= 0 ? uchar(a >> RESULT_SHIFT) : 0xff;
+        dst += 4;
+    }
+}
+}
+
+QImage PosterScaler::scaled(const QImage &source, const QSize &size, Kernel kernel)
+{
+    if (source.isNull()) {
+        return QImage();
+    }
+    if (kernel == Auto || !isSupported(kernel)) {
+        kernel = bestKernel();
+    }
+    const Kernels kernels = kernelsFor(kernel);
+
+    Layout layout;
+    const QImage image = normalizedSource(source, &layout);
+    const int sourceWidth = image.width();
+    const int sourceHeight = image.height();
+    const int width = size.isValid() ? qBound(1, size.width(), sourceWidth) : sourceWidth;
+    const int height = size.isValid() ? qBound(1, size.height(), sourceHeight) : sourceHeight;
+
+    QImage result(width, height, QImage::Format_RGBA8888_Premultiplied);
+    if (result.isNull()) {
+        return QImage();
+    }
+
+    if (width == sourceWidth && height == sourceHeight) {
+        for (int y = 0; y < height; ++y) {
+            convertRow(result.scanLine(y), image.constScanLine(y), width, layout, kernels);
+        }
+        return result;
+    }
+
+    const Taps columns = computeTaps(sourceWidth, width);
+    const Taps rows = computeTaps(sourceHeight, height);
+    const int rowBytes = sourceWidth * layout.bpp;
+    QVector<quint32> acc(rowBytes);
+
+    for (int y = 0; y < height; ++y) {
+        const Tap &tap = rows.taps.at(y);
+        std::memset(acc.data(), 0, rowBytes * sizeof(quint32));
+        for (int k = 0; k < tap.count; ++k) {
+            kernels.accumulate(acc.data(), image.constScanLine(tap.first + k), rowBytes,
+                               rows.weights.at(tap.offset + k));
+        }
+        resolveRow(result.scanLine(y), acc.constData(), columns, layout);
+    }
+    return result;
+}
+
+PosterScaler::Kernel PosterScaler::bestKernel()
+{
+    static const Kernel best = isSupported(Avx2) ? Avx2
+                             : isSupported(Sse41) ? Sse41
+                             : isSupported(Neon) ? Neon
+                             : Scalar;
+    return best;
+}
+
+bool PosterScaler::isSupported(Kernel kernel)
+{
+    switch (kernel) {
+    case Scalar:
+        return true;
+#ifdef POSTERSCALER_X86
+    case Sse41:
+        return __builtin_cpu_supports("sse4.1");
+    case Avx2:
+        return __builtin_cpu_supports("avx2");
+#endif
+#ifdef POSTERSCALER_NEON
+    case Neon:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+const char *PosterScaler::kernelName(Kernel kernel)
+{
+    switch (kernel) {
+    case Auto:
+        return "auto";
+    case Scalar:
+        return "scalar";
+    case Sse41:
+        return "sse4.1";
+    case Avx2:
+        return "avx2";
+    case Neon:
+        return "neon";
+    }
+    return "unknown";
+}
@@ -0,0 +1,37 @@
+#ifndef POSTERSCALER_H
+#define POSTERSCALER_H
+
+#include <QImage>
+#include <QSize>
+
+// Downscales a decoded image to poster size and converts it to the upload
+// format in a single pass, replacing convertToFormat() followed by
+// QImage::scaled(SmoothTransformation) and their two full size temporaries.
+//
+// The filter is an area average like Qt's smooth scaling. Source rows are
+// accumulated into one row buffer (the part touching every source byte,
+// vectorized with SSE4.1, AVX2 or NEON) and every finished output row is
+// filtered horizontally and written straight as RGBA8888. The result is
+// Format_RGBA8888_Premultiplied, which the atlas uploads without another
+// conversion. Reentrant, meant to run on the decode workers.
+class PosterScaler
+{
+public:
+    enum Kernel {
+        Auto,       // best kernel this CPU supports
+        Scalar,
+        Sse41,
+        Avx2,
+        Neon
+    };
+
+    // Never upscales: a size larger than the source on either axis keeps
+    // the source size there. An invalid size only converts.
+    static QImage scaled(const QImage &source, const QSize &size, Kernel kernel = Auto);
+
+    static Kernel bestKernel();
+    static bool isSupported(Kernel kernel);
+    static const char *kernelName(Kernel kernel);
+};
+
+#endif // POSTERSCALER_H
@@ -0,0 +1,222 @@
+#include "swimlaneanimator.h"
+#include "swimlanenodes.h"
+#include <QQuickWindow>
+
+SwimlaneAnimator::SwimlaneAnimator(QQuickWindow *window, SwimlaneRootNode *root)
+    : m_window(window)
+    , m_root(root)
+    , m_easing(QEasingCurve::OutCubic)
+    , m_contentRunning(false)
+    , m_focusFrom(-1)
+    , m_focusTo(-1)
+    , m_focusRunning(false)
+{
+    m_clock.start();
+    // Direct, so advance() runs on the render thread right before drawing
+    connect(window, &QQuickWindow::beforeRendering, this, &SwimlaneAnimator::advance,
+            Qt::DirectConnection);
+}
+
+void SwimlaneAnimator::scrollRow(int row, qreal toX, int duration)
+{
+    if (row < 0 || row >= m_root->rows().size()) {
+        return;
+    }
+    qreal fromX = m_root->rows().at(row)->scrollX();
+    if (duration <= 0 || fromX == toX) {
+        m_rowScrolls.remove(row);
+        applyRow(row, toX);
+        return;
+    }
+    // Start from what is on screen, so key repeat never jumps back
+    m_rowScrolls.insert(row, Animation{ fromX, toX, m_clock.elapsed(), duration });
+}
+
+void SwimlaneAnimator::scrollContent(qreal toY, int duration)
+{
+    qreal fromY = m_root->contentY();
+    if (duration <= 0 || fromY == toY) {
+        m_contentRunning = false;
+        m_root->setContentY(toY);
+        return;
+    }
+    m_content = Animation{ fromY, toY, m_clock.elapsed(), duration };
+    m_contentRunning = true;
+}
+
+void SwimlaneAnimator::focus(int fromIndex, int toIndex, int duration)
+{
+    // A focus move in the middle of another one settles the older poster
+    if (m_focusRunning && m_focusFrom != toIndex) {
+        applyFocus(m_focusFrom, 0);
+    }
+
+    m_focusFrom = fromIndex;
+    m_focusTo = toIndex;
+    if (duration <= 0) {
+        m_focusRunning = false;
+        applyFocus(fromIndex, 0);
+        applyFocus(toIndex, 1);
+        return;
+    }
+    m_focus = Animation{ 0, 1, m_clock.elapsed(), duration };
+    m_focusRunning = true;
+    applyFocus(fromIndex, 1);
+    applyFocus(toIndex, 0);
+}
+
+void SwimlaneAnimator::reveal(int index, int duration)
+{
+    if (duration <= 0) {
+        m_reveals.remove(index);
+        applyReveal(index, 1);
+        return;
+    }
+    if (!m_reveals.contains(index)) {
+        m_reveals.insert(index, Animation{ 0, 1, m_clock.elapsed(), duration });
+        applyReveal(index, 0);
+    }
+}
+
+void SwimlaneAnimator::conceal(int index)
+{
+    m_reveals.remove(index);
+    applyReveal(index, 0);
+}
+
+void SwimlaneAnimator::retargetRow(int row, qreal toX)
+{
+    auto it = m_rowScrolls.find(row);
+    if (it != m_rowScrolls.end()) {
+        it->to = toX;
+    } else {
+        applyRow(row, toX);
+    }
+}
+
+void SwimlaneAnimator::retargetContent(qreal toY)
+{
+    if (m_contentRunning) {
+        m_content.to = toY;
+    } else {
+        m_root->setContentY(toY);
+    }
+}
+
+qreal SwimlaneAnimator::rowScrollX(int row) const
+{
+    auto it = m_rowScrolls.constFind(row);
+    if (it != m_rowScrolls.constEnd()) {
+        return it->to;
+    }
+    return row >= 0 && row < m_root->rows().size() ? m_root->rows().at(row)->scrollX() : 0;
+}
+
+void SwimlaneAnimator::rowScrollRange(int row, qreal *minX, qreal *maxX) const
+{
+    qreal current = row >= 0 && row < m_root->rows().size() ? m_root->rows().at(row)->scrollX() : 0;
+    qreal target = rowScrollX(row);
+    *minX = qMin(current, target);
+    *maxX = qMax(current, target);
+}
+
+void SwimlaneAnimator::contentRange(qreal *minY, qreal *maxY) const
+{
+    qreal current = m_root->contentY();
+    qreal target = m_contentRunning ? m_content.to : current;
+    *minY = qMin(current, target);
+    *maxY = qMax(current, target);
+}
+
+void SwimlaneAnimator::clearRows()
+{
+    m_rowScrolls.clear();
+}
+
+bool SwimlaneAnimator::isRunning() const
+{
+    return !m_rowScrolls.isEmpty() || m_contentRunning || m_focusRunning || !m_reveals.isEmpty();
+}
+
+void SwimlaneAnimator::advance()
+{
+    if (!isRunning()) {
+        return;
+    }
+
+    const qint64 now = m_clock.elapsed();
+
+    for (auto it = m_rowScrolls.begin(); it != m_rowScrolls.end(); ) {
+        qreal t = progress(*it, now);
+        applyRow(it.key(), it->from + (it->to - it->from) * m_easing.valueForProgress(t));
+        if (t >= 1) {
+            it = m_rowScrolls.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (m_contentRunning) {
+        qreal t = progress(m_content, now);
+        m_root->setContentY(m_content.from + (m_content.to - m_content.from) * m_easing.valueForProgress(t));
+        m_contentRunning = t < 1;
+    }
+
+    if (m_focusRunning) {
+        qreal t = progress(m_focus, now);
+        qreal amount = m_easing.valueForProgress(t);
+        applyFocus(m_focusFrom, 1 - amount);
+        applyFocus(m_focusTo, amount);
+        m_focusRunning = t < 1;
+    }
+
+    for (auto it = m_reveals.begin(); it != m_reveals.end(); ) {
+        qreal t = progress(*it, now);
+        applyReveal(it.key(), m_easing.valueForProgress(t));
+        if (t >= 1) {
+            it = m_reveals.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // Keep rendering without a sync until everything settled; from the
+    // render thread this does not wake the GUI thread
+    if (isRunning()) {
+        m_window->update();
+    }
+}
+
+qreal SwimlaneAnimator::progress(const Animation &animation, qint64 now) const
+{
+    if (animation.duration <= 0) {
+        return 1;
+    }
+    return qBound<qreal>(0, qreal(now - animation.start) / animation.duration, 1);
+}
+
+void SwimlaneAnimator::applyRow(int row, qreal x)
+{
+    if (row >= 0 && row < m_root->rows().size()) {
+        m_root->rows().at(row)->setScrollX(x);
+    }
+}
+
+void SwimlaneAnimator::applyFocus(int index, qreal amount)
+{
+    if (index < 0) {
+        return;
+    }
+    SwimlaneRowNode *row = m_root->rowForIndex(index);
+    if (PosterNode *poster = row ? row->poster(index) : nullptr) {
+        poster->setFocusAmount(amount);
+    }
+}
+
+void SwimlaneAnimator::applyReveal(int index, qreal amount)
+{
+    SwimlaneRowNode *row = m_root->rowForIndex(index);
+    if (PosterNode *poster = row ? row->poster(index) : nullptr) {
+        poster->setReveal(amount);
+    }
+}
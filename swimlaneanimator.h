@@ -0,0 +1,87 @@
+#ifndef SWIMLANEANIMATOR_H
+#define SWIMLANEANIMATOR_H
+
+#include <QObject>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QEasingCurve>
+
+class QQuickWindow;
+class SwimlaneRootNode;
+
+// Scroll and focus animations that run on the render thread, the same idea
+// as QQuickAnimator. The view only hands over targets while updatePaintNode
+// syncs; every frame advance() runs from beforeRendering, writes the row,
+// content and focus state straight into the nodes and asks the window for
+// another frame. The GUI thread can be blocked the whole time.
+//
+// Rows and posters are looked up by index on every frame, so nodes being
+// recycled or rebuilt underneath an animation is harmless.
+class SwimlaneAnimator : public QObject
+{
+    Q_OBJECT
+
+public:
+    SwimlaneAnimator(QQuickWindow *window, SwimlaneRootNode *root);
+
+    // All of these are called during sync, the GUI thread is blocked.
+    // A duration of 0 jumps to the target and stops a running animation.
+    void scrollRow(int row, qreal toX, int duration);
+    void scrollContent(qreal toY, int duration);
+    void focus(int fromIndex, int toIndex, int duration);
+    // Crossfades the poster from its placeholder to its texture, or back
+    // to the placeholder right away when the texture went away
+    void reveal(int index, int duration);
+    void conceal(int index);
+
+    // Layout changed while an animation might run: keep its timing but end
+    // at the new target, or just apply the value when nothing runs
+    void retargetRow(int row, qreal toX);
+    void retargetContent(qreal toY);
+
+    // Where the row or content is heading, or is now when nothing runs
+    qreal rowScrollX(int row) const;
+    // Leftmost and rightmost scroll position the row will show until its
+    // animation ends, used to keep enough posters materialized
+    void rowScrollRange(int row, qreal *minX, qreal *maxX) const;
+    void contentRange(qreal *minY, qreal *maxY) const;
+
+    // Rows were rebuilt, row animations no longer apply
+    void clearRows();
+    bool isRunning() const;
+
+public slots:
+    // Render thread, connected to QQuickWindow::beforeRendering
+    void advance();
+
+private:
+    struct Animation {
+        qreal from;
+        qreal to;
+        qint64 start;
+        int duration;
+    };
+
+    qreal progress(const Animation &animation, qint64 now) const;
+    void applyRow(int row, qreal x);
+    void applyFocus(int index, qreal amount);
+    void applyReveal(int index, qreal amount);
+
+    QQuickWindow *m_window;
+    SwimlaneRootNode *m_root;
+    QElapsedTimer m_clock;
+    QEasingCurve m_easing;
+
+    QHash<int, Animation> m_rowScrolls;
+    Animation m_content;
+    bool m_contentRunning;
+
+    int m_focusFrom;
+    int m_focusTo;
+    Animation m_focus;
+    bool m_focusRunning;
+
+    QHash<int, Animation> m_reveals;
+};
+
+#endif // SWIMLANEANIMATOR_H
@@ -0,0 +1,410 @@
+#include "swimlanenodes.h"
+#include "titletexturecache.h"
+#include "glyphtext.h"
+#include "swimlaneanimator.h"
+#include <QSGTexture>
+#include <QColor>
+#include <algorithm>
+
+QRectF focusedPosterRect(const QRectF &rect, const FocusStyle &style)
+{
+    // Same math as the poster shader
+    qreal widthDiff = rect.width() * (style.scale - 1.0);
+    qreal heightDiff = rect.height() * (style.scale - 1.0);
+    return QRectF(rect.x() - widthDiff / 2,
+                  rect.y() - heightDiff / 2,
+                  rect.width() * style.scale,
+                  rect.height() * style.scale);
+}
+
+void setTexturedRectGeometry(QSGGeometry *geometry, const QRectF &rect, const QRectF &sourceRect)
+{
+    QSGGeometry::TexturedPoint2D *vertices = geometry->vertexDataAsTexturedPoint2D();
+    vertices[0].set(rect.left(), rect.top(), sourceRect.left(), sourceRect.top());
+    vertices[1].set(rect.right(), rect.top(), sourceRect.right(), sourceRect.top());
+    vertices[2].set(rect.left(), rect.bottom(), sourceRect.left(), sourceRect.bottom());
+    vertices[3].set(rect.right(), rect.bottom(), sourceRect.right(), sourceRect.bottom());
+}
+
+// PosterNode
+
+PosterNode::PosterNode(int index)
+    : m_index(index)
+    , m_sourceRect(0, 0, 1, 1)
+    , m_placeholder(0)
+    , m_reveal(0)
+    , m_geometry(PosterMaterial::attributes(), 4)
+{
+    m_geometry.setDrawingMode(GL_TRIANGLE_STRIP);
+    setGeometry(&m_geometry);
+    setMaterial(&m_material);
+}
+
+void PosterNode::reset(int index)
+{
+    m_index = index;
+    m_rect = QRectF();
+    m_sourceRect = QRectF(0, 0, 1, 1);
+    m_placeholder = 0;
+    m_reveal = 0;
+    m_material.setTexture(nullptr);
+    m_material.setFocused(false);
+}
+
+void PosterNode::setRect(const QRectF &rect)
+{
+    if (m_rect == rect) {
+        return;
+    }
+    m_rect = rect;
+    updateGeometry();
+}
+
+void PosterNode::setTexture(QSGTexture *texture)
+{
+    if (m_material.texture() == texture) {
+        return;
+    }
+    m_material.setTexture(texture);
+    markDirty(DirtyMaterial);
+
+    // Atlas textures only cover part of the page
+    if (texture && texture->normalizedTextureSubRect() != m_sourceRect) {
+        updateGeometry();
+    }
+}
+
+void PosterNode::refreshTexture()
+{
+    QSGTexture *texture = m_material.texture();
+    if (!texture || !texture->isAtlasTexture()) {
+        return;
+    }
+    markDirty(DirtyMaterial);
+    if (texture->normalizedTextureSubRect() != m_sourceRect) {
+        updateGeometry();
+    }
+}
+
+void PosterNode::setPlaceholderColor(QRgb color)
+{
+    if (m_placeholder == color) {
+        return;
+    }
+    m_placeholder = color;
+    updateGeometry();
+}
+
+void PosterNode::setReveal(qreal amount)
+{
+    amount = qBound<qreal>(0, amount, 1);
+    if (m_reveal == amount) {
+        return;
+    }
+    // Four vertices per frame while fading, only for the posters that do
+    m_reveal = amount;
+    updateGeometry();
+}
+
+void PosterNode::setFocused(bool focused, const FocusStyle &style)
+{
+    setFocusAmount(focused ? 1.0 : 0.0, style);
+}
+
+void PosterNode::setFocusAmount(qreal amount, const FocusStyle &style)
+{
+    if (m_material.focusAmount() == amount && amount == 0) {
+        return;
+    }
+    // Material state only, the renderer keeps the uploaded vertices
+    m_material.setFocusAmount(amount, style);
+    markDirty(DirtyMaterial);
+}
+
+void PosterNode::updateGeometry()
+{
+    QSGTexture *texture = m_material.texture();
+    m_sourceRect = texture ? texture->normalizedTextureSubRect() : QRectF(0, 0, 1, 1);
+    PosterMaterial::updateGeometry(&m_geometry, m_rect, m_sourceRect, m_placeholder, m_reveal);
+    markDirty(DirtyGeometry);
+}
+
+// PosterNodePool
+
+PosterNodePool::PosterNodePool(int maxIdle)
+    : m_liveCount(0)
+    , m_maxIdle(maxIdle)
+{
+}
+
+PosterNodePool::~PosterNodePool()
+{
+    // Live nodes belong to the tree and are deleted with it
+    qDeleteAll(m_idle);
+}
+
+PosterNode *PosterNodePool::acquire(int index)
+{
+    ++m_liveCount;
+    if (m_idle.isEmpty()) {
+        return new PosterNode(index);
+    }
+    PosterNode *node = m_idle.takeLast();
+    node->reset(index);
+    return node;
+}
+
+void PosterNodePool::release(PosterNode *node)
+{
+    --m_liveCount;
+    // Drop the texture now, it may be deleted before the node is reused
+    node->reset(-1);
+    if (m_idle.size() < m_maxIdle) {
+        m_idle.append(node);
+    } else {
+        delete node;
+    }
+}
+
+// SwimlaneRowNode
+
+SwimlaneRowNode::SwimlaneRowNode(int row, int firstIndex, int itemCount, PosterNodePool *pool)
+    : m_row(row)
+    , m_firstIndex(firstIndex)
+    , m_itemCount(itemCount)
+    , m_materializedFirst(0)
+    , m_materializedLast(-1)
+    , m_rowY(0)
+    , m_scrollX(0)
+    , m_clipGeometry(QSGGeometry::defaultAttributes_Point2D(), 4)
+    , m_pool(pool)
+    , m_titleNode(nullptr)
+    , m_titleTexture(nullptr)
+    , m_textNode(nullptr)
+{
+    // Clip and scroll nodes are members, the row never owns them as children
+    m_clipNode.setFlag(QSGNode::OwnedByParent, false);
+    m_scrollNode.setFlag(QSGNode::OwnedByParent, false);
+    m_clipNode.setIsRectangular(true);
+    m_clipNode.setGeometry(&m_clipGeometry);
+    m_clipNode.appendChildNode(&m_scrollNode);
+    appendChildNode(&m_clipNode);
+}
+
+SwimlaneRowNode::~SwimlaneRowNode()
+{
+    // QSGNode only deletes children it owns, the clip and scroll nodes are
+    // members so their children are deleted here. The title is a regular
+    // child, its texture goes back to the cache.
+    m_scrollNode.removeAllChildNodes();
+    m_clipNode.removeAllChildNodes();
+    removeChildNode(&m_clipNode);
+    delete m_textNode;
+    qDeleteAll(m_posters);
+    TitleTextureCache::instance().release(m_titleTexture);
+}
+
+void SwimlaneRowNode::setRowY(qreal y)
+{
+    if (m_rowY == y) {
+        return;
+    }
+    m_rowY = y;
+    QMatrix4x4 matrix;
+    matrix.translate(0, y);
+    setMatrix(matrix);
+}
+
+void SwimlaneRowNode::setScrollX(qreal x)
+{
+    if (m_scrollX == x) {
+        return;
+    }
+    m_scrollX = x;
+    QMatrix4x4 matrix;
+    matrix.translate(x, 0);
+    m_scrollNode.setMatrix(matrix);
+}
+
+void SwimlaneRowNode::setClipRect(const QRectF &rect)
+{
+    if (m_clipNode.clipRect() == rect) {
+        return;
+    }
+    m_clipNode.setClipRect(rect);
+    QSGGeometry::updateRectGeometry(&m_clipGeometry, rect);
+    m_clipNode.markDirty(QSGNode::DirtyGeometry);
+}
+
+void SwimlaneRowNode::setTitleNode(QSGGeometryNode *node, QSGTexture *texture)
+{
+    if (m_titleNode) {
+        removeChildNode(m_titleNode);
+        delete m_titleNode;
+    }
+    TitleTextureCache::instance().release(m_titleTexture);
+
+    m_titleNode = node;
+    m_titleTexture = texture;
+    if (m_titleNode) {
+        prependChildNode(m_titleNode);
+    }
+}
+
+void SwimlaneRowNode::setTitlePosition(const QPointF &pos)
+{
+    if (!m_titleNode) {
+        return;
+    }
+
+    // Title width is fixed at creation, only move the quad
+    QSGGeometry *geometry = m_titleNode->geometry();
+    QSGGeometry::TexturedPoint2D *vertices = geometry->vertexDataAsTexturedPoint2D();
+    if (vertices[0].x == float(pos.x()) && vertices[0].y == float(pos.y())) {
+        return;
+    }
+    QRectF rect(pos, QSizeF(vertices[3].x - vertices[0].x, vertices[3].y - vertices[0].y));
+    setTexturedRectGeometry(geometry, rect, m_titleTexture->normalizedTextureSubRect());
+    m_titleNode->markDirty(QSGNode::DirtyGeometry);
+}
+
+void SwimlaneRowNode::setTextNode(GlyphTextNode *node)
+{
+    if (m_textNode) {
+        m_scrollNode.removeChildNode(m_textNode);
+        delete m_textNode;
+    }
+    m_textNode = node;
+    if (m_textNode) {
+        m_scrollNode.appendChildNode(m_textNode);
+    }
+}
+
+PosterNode *SwimlaneRowNode::ensurePoster(int index)
+{
+    PosterNode *node = m_posters.value(index, nullptr);
+    if (!node) {
+        node = m_pool->acquire(index);
+        m_posters.insert(index, node);
+        // Text overlays the posters, keep it last
+        if (m_textNode) {
+            m_scrollNode.insertChildNodeBefore(node, m_textNode);
+        } else {
+            m_scrollNode.appendChildNode(node);
+        }
+    }
+    return node;
+}
+
+void SwimlaneRowNode::setMaterializedRange(int first, int last)
+{
+    m_materializedFirst = first;
+    m_materializedLast = last;
+
+    for (auto it = m_posters.begin(); it != m_posters.end(); ) {
+        if (isMaterialized(it.key())) {
+            ++it;
+            continue;
+        }
+        m_scrollNode.removeChildNode(it.value());
+        m_pool->release(it.value());
+        it = m_posters.erase(it);
+    }
+}
+
+void SwimlaneRowNode::releaseAllPosters()
+{
+    setMaterializedRange(0, -1);
+}
+
+// SwimlaneRootNode
+
+SwimlaneRootNode::SwimlaneRootNode()
+    : m_contentY(0)
+    , m_animator(nullptr)
+{
+    m_contentNode.setFlag(QSGNode::OwnedByParent, false);
+    appendChildNode(&m_contentNode);
+}
+
+SwimlaneRootNode::~SwimlaneRootNode()
+{
+    // Rows are children of the member content node, delete them ourselves
+    clearRows();
+    removeChildNode(&m_contentNode);
+    delete m_animator;
+}
+
+void SwimlaneRootNode::setContentY(qreal y)
+{
+    if (m_contentY == y) {
+        return;
+    }
+    m_contentY = y;
+    QMatrix4x4 matrix;
+    matrix.translate(0, -y);
+    m_contentNode.setMatrix(matrix);
+}
+
+void SwimlaneRootNode::setAnimator(SwimlaneAnimator *animator)
+{
+    delete m_animator;
+    m_animator = animator;
+}
+
+void SwimlaneRootNode::clearRows()
+{
+    for (SwimlaneRowNode *row : m_rows) {
+        // Hand the posters back so the next model can reuse them
+        row->releaseAllPosters();
+        m_contentNode.removeChildNode(row);
+        delete row;
+    }
+    m_rows.clear();
+}
+
+void SwimlaneRootNode::appendRow(SwimlaneRowNode *row)
+{
+    m_rows.append(row);
+    m_contentNode.appendChildNode(row);
+}
+
+SwimlaneRowNode *SwimlaneRootNode::rowForIndex(int index) const
+{
+    // Rows are stored in item order, so a binary search on firstIndex works
+    auto it = std::upper_bound(m_rows.constBegin(), m_rows.constEnd(), index,
+                               [](int value, const SwimlaneRowNode *row) {
+                                   return value < row->firstIndex();
+                               });
+    if (it == m_rows.constBegin()) {
+        return nullptr;
+    }
+    --it;
+    return (*it)->containsIndex(index) ? *it : nullptr;
+}
+
+void SwimlaneRootNode::refreshTextures()
+{
+    for (SwimlaneRowNode *row : m_rows) {
+        const QHash<int, PosterNode*> &posters = row->posters();
+        for (auto it = posters.constBegin(); it != posters.constEnd(); ++it) {
+            it.value()->refreshTexture();
+        }
+    }
+}
+
+int SwimlaneRootNode::nodeCount() const
+{
+    // Root and content transform, then every row is a transform, a clip
+    // and a scroll transform
+    int count = 2 + 3 * m_rows.size() + m_pool.liveCount();
+    for (const SwimlaneRowNode *row : m_rows) {
+        if (row->titleNode()) {
+            ++count;
+        }
+        if (row->textNode()) {
+            ++count;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,198 @@
+#ifndef SWIMLANENODES_H
+#define SWIMLANENODES_H
+
+#include <QSGNode>
+#include <QSGGeometryNode>
+#include <QSGGeometry>
+#include <QSGTransformNode>
+#include <QSGClipNode>
+#include <QHash>
+#include <QVector>
+#include <QRectF>
+#include "postermaterial.h"
+
+class QSGTexture;
+class GlyphTextNode;
+class SwimlaneAnimator;
+
+// Retained scene graph nodes used by CustomImageListView.
+// Nodes are created once and only the parts that change are updated and
+// marked dirty, instead of rebuilding the whole tree on every update().
+
+// Single poster quad. Owns its geometry and material as members, like
+// QSGSimpleTextureNode does, so no per-frame allocation happens. Focus zoom
+// and border are drawn by PosterMaterial, focusing never touches the geometry.
+class PosterNode : public QSGGeometryNode
+{
+public:
+    explicit PosterNode(int index);
+
+    int index() const { return m_index; }
+    // Rebinds a pooled node to another item, clearing its previous state
+    void reset(int index);
+
+    void setRect(const QRectF &rect);
+    QRectF rect() const { return m_rect; }
+
+    void setTexture(QSGTexture *texture);
+    QSGTexture *texture() const { return m_material.texture(); }
+    // Atlas textures can move between pages, pick up the new placement
+    void refreshTexture();
+
+    // Shown until the texture is revealed, 0 is placeholder only and 1 the
+    // texture only; the crossfade animates in between
+    void setPlaceholderColor(QRgb color);
+    QRgb placeholderColor() const { return m_placeholder; }
+    void setReveal(qreal amount);
+    qreal reveal() const { return m_reveal; }
+
+    void setFocused(bool focused, const FocusStyle &style = FocusStyle());
+    void setFocusAmount(qreal amount, const FocusStyle &style = FocusStyle());
+    bool isFocused() const { return m_material.isFocused(); }
+
+private:
+    void updateGeometry();
+
+    int m_index;
+    QRectF m_rect;
+    QRectF m_sourceRect;
+    QRgb m_placeholder;
+    qreal m_reveal;
+    QSGGeometry m_geometry;
+    PosterMaterial m_material;
+};
+
+// Recycles poster nodes as they scroll in and out of the viewport, the
+// same way ListView pools its delegates. Idle nodes are detached from the
+// tree and kept up to maxIdle, anything beyond that is deleted.
+class PosterNodePool
+{
+public:
+    explicit PosterNodePool(int maxIdle = 64);
+    ~PosterNodePool();
+
+    PosterNode *acquire(int index);
+    void release(PosterNode *node);
+
+    int liveCount() const { return m_liveCount; }
+    int idleCount() const { return m_idle.size(); }
+
+private:
+    QVector<PosterNode*> m_idle;
+    int m_liveCount;
+    int m_maxIdle;
+};
+
+// One swimlane: the title plus the poster nodes keyed by item index.
+// Only the columns inside the materialized range have poster nodes. The
+// title texture is borrowed from TitleTextureCache and released with the row.
+// Poster metadata of the whole row lives in one text node drawn last.
+//
+// The row is a transform node placing it vertically, posters and text sit
+// in row content coordinates under a clip and a scroll transform:
+//
+//   SwimlaneRowNode (row y) -> title
+//                           -> QSGClipNode -> QSGTransformNode (scroll x) -> posters, text
+//
+// so scrolling a row only changes one matrix and no geometry.
+class SwimlaneRowNode : public QSGTransformNode
+{
+public:
+    SwimlaneRowNode(int row, int firstIndex, int itemCount, PosterNodePool *pool);
+    ~SwimlaneRowNode();
+
+    int row() const { return m_row; }
+    int firstIndex() const { return m_firstIndex; }
+    int itemCount() const { return m_itemCount; }
+    bool containsIndex(int index) const {
+        return index >= m_firstIndex && index < m_firstIndex + m_itemCount;
+    }
+
+    void setRowY(qreal y);
+    void setScrollX(qreal x);
+    void setClipRect(const QRectF &rect);
+
+    void setTitleNode(QSGGeometryNode *node, QSGTexture *texture);
+    QSGGeometryNode *titleNode() const { return m_titleNode; }
+    void setTitlePosition(const QPointF &pos);
+    qreal scrollX() const { return m_scrollX; }
+
+    void setTextNode(GlyphTextNode *node);
+    GlyphTextNode *textNode() const { return m_textNode; }
+
+    PosterNode *poster(int index) const { return m_posters.value(index, nullptr); }
+    PosterNode *ensurePoster(int index);
+    const QHash<int, PosterNode*> &posters() const { return m_posters; }
+
+    // Columns [first, last] of this row that should have nodes; posters
+    // outside the new range go back to the pool
+    void setMaterializedRange(int first, int last);
+    int materializedFirst() const { return m_materializedFirst; }
+    int materializedLast() const { return m_materializedLast; }
+    bool isMaterialized(int index) const {
+        int column = index - m_firstIndex;
+        return column >= m_materializedFirst && column <= m_materializedLast;
+    }
+    void releaseAllPosters();
+
+private:
+    int m_row;
+    int m_firstIndex;
+    int m_itemCount;
+    int m_materializedFirst;
+    int m_materializedLast;
+    qreal m_rowY;
+    qreal m_scrollX;
+    QSGClipNode m_clipNode;
+    QSGGeometry m_clipGeometry;
+    QSGTransformNode m_scrollNode;
+    PosterNodePool *m_pool;
+    QSGGeometryNode *m_titleNode;
+    QSGTexture *m_titleTexture;
+    GlyphTextNode *m_textNode;
+    QHash<int, PosterNode*> m_posters;
+};
+
+// Root of the retained tree. Rows are kept in layout order so a row can be
+// found from an item index without walking the tree. Rows sit at their
+// content y under one transform, so vertical scrolling is a single matrix.
+class SwimlaneRootNode : public QSGNode
+{
+public:
+    SwimlaneRootNode();
+    ~SwimlaneRootNode();
+
+    void setContentY(qreal y);
+    qreal contentY() const { return m_contentY; }
+
+    void clearRows();
+    void appendRow(SwimlaneRowNode *row);
+    const QVector<SwimlaneRowNode*> &rows() const { return m_rows; }
+    SwimlaneRowNode *rowForIndex(int index) const;
+    void refreshTextures();
+
+    PosterNodePool *pool() { return &m_pool; }
+    // Nodes currently in the tree, pooled nodes are not counted
+    int nodeCount() const;
+
+    // Render thread animations of this tree, deleted with it
+    void setAnimator(SwimlaneAnimator *animator);
+    SwimlaneAnimator *animator() const { return m_animator; }
+
+private:
+    QVector<SwimlaneRowNode*> m_rows;
+    qreal m_contentY;
+    QSGTransformNode m_contentNode;
+    PosterNodePool m_pool;
+    SwimlaneAnimator *m_animator;
+};
+
+// Rect a poster covers while focused, the focus zoom scales around the center
+QRectF focusedPosterRect(const QRectF &rect, const FocusStyle &style = FocusStyle());
+
+// Writes a rectangle into a 4 vertex textured triangle strip. sourceRect is
+// the normalized sub rect of the texture, which is not 0..1 for atlas textures.
+void setTexturedRectGeometry(QSGGeometry *geometry, const QRectF &rect,
+                             const QRectF &sourceRect = QRectF(0, 0, 1, 1));
+
+#endif // SWIMLANENODES_H
@@ -0,0 +1,474 @@
+#include "textureatlas.h"
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QVector>
+#include <QDebug>
+#include <cstring>
+
+namespace {
+// Pages below this occupancy are candidates for defragmentation
+const qreal DEFRAGMENT_OCCUPANCY = 0.35;
+// A shelf is reused for an image when it wastes at most a quarter of its height
+const int SHELF_FIT_NUMERATOR = 5;
+const int SHELF_FIT_DENOMINATOR = 4;
+
+// Adds a 1px border replicating the edge pixels so linear filtering
+// never samples a neighbouring texture on the page
+QImage paddedImage(const QImage &source)
+{
+    // The scene graph expects premultiplied alpha
+    QImage image = source.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
+    const int w = image.width();
+    const int h = image.height();
+
+    QImage padded(w + 2, h + 2, QImage::Format_RGBA8888_Premultiplied);
+    for (int y = 0; y < h + 2; ++y) {
+        const quint32 *src = reinterpret_cast<const quint32 *>(image.constScanLine(qBound(0, y - 1, h - 1)));
+        quint32 *dst = reinterpret_cast<quint32 *>(padded.scanLine(y));
+        dst[0] = src[0];
+        std::memcpy(dst + 1, src, w * sizeof(quint32));
+        dst[w + 1] = src[w - 1];
+    }
+    return padded;
+}
+}
+
+class TextureAtlasPage
+{
+public:
+    struct Span {
+        int x;
+        int width;
+    };
+
+    struct Shelf {
+        int y;
+        int height;
+        QVector<Span> freeSpans;   // Sorted by x
+    };
+
+    struct PendingUpload {
+        AtlasTexture *texture;
+        QRect rect;
+        QImage image;
+    };
+
+    explicit TextureAtlasPage(const QSize &size)
+        : size(size)
+        , textureId(0)
+        , shelfBottom(0)
+        , usedArea(0)
+    {
+    }
+
+    ~TextureAtlasPage()
+    {
+        // GL resources can only be released with the context current
+        QOpenGLContext *context = QOpenGLContext::currentContext();
+        if (textureId && context) {
+            context->functions()->glDeleteTextures(1, &textureId);
+        }
+    }
+
+    qreal occupancy() const
+    {
+        return qreal(usedArea) / (size.width() * size.height());
+    }
+
+    bool allocate(const QSize &request, QRect *rect);
+    void free(const QRect &rect);
+    void ensureCreated(QOpenGLFunctions *f);
+    void upload(QOpenGLFunctions *f);
+
+    QSize size;
+    GLuint textureId;
+    QVector<Shelf> shelves;
+    int shelfBottom;
+    int usedArea;
+    QList<AtlasTexture*> textures;
+    QList<PendingUpload> pending;
+};
+
+bool TextureAtlasPage::allocate(const QSize &request, QRect *rect)
+{
+    const int w = request.width();
+    const int h = request.height();
+
+    // Best fit: the shelf with the least wasted height that has a wide enough span
+    int bestShelf = -1;
+    int bestSpan = -1;
+    for (int i = 0; i < shelves.size(); ++i) {
+        const Shelf &shelf = shelves[i];
+        bool empty = shelf.freeSpans.size() == 1 && shelf.freeSpans[0].width == size.width();
+        if (shelf.height < h
+                || (!empty && shelf.height * SHELF_FIT_DENOMINATOR > h * SHELF_FIT_NUMERATOR)) {
+            continue;
+        }
+        if (bestShelf != -1 && shelves[bestShelf].height <= shelf.height) {
+            continue;
+        }
+        for (int s = 0; s < shelf.freeSpans.size(); ++s) {
+            if (shelf.freeSpans[s].width >= w) {
+                bestShelf = i;
+                bestSpan = s;
+                break;
+            }
+        }
+    }
+
+    if (bestShelf == -1) {
+        // Open a new shelf at the bottom of the page
+        if (shelfBottom + h > size.height() || w > size.width()) {
+            return false;
+        }
+        Shelf shelf;
+        shelf.y = shelfBottom;
+        shelf.height = h;
+        shelf.freeSpans.append(Span{0, size.width()});
+        shelves.append(shelf);
+        shelfBottom += h;
+        bestShelf = shelves.size() - 1;
+        bestSpan = 0;
+    }
+
+    Shelf &shelf = shelves[bestShelf];
+    Span &span = shelf.freeSpans[bestSpan];
+    *rect = QRect(span.x, shelf.y, w, h);
+    span.x += w;
+    span.width -= w;
+    if (span.width == 0) {
+        shelf.freeSpans.remove(bestSpan);
+    }
+
+    usedArea += w * h;
+    return true;
+}
+
+void TextureAtlasPage::free(const QRect &rect)
+{
+    int shelfIndex = -1;
+    for (int i = 0; i < shelves.size(); ++i) {
+        if (shelves[i].y == rect.y()) {
+            shelfIndex = i;
+            break;
+        }
+    }
+    if (shelfIndex == -1) {
+        return;
+    }
+
+    usedArea -= rect.width() * rect.height();
+
+    // Insert the span back in x order and merge it with its neighbours
+    QVector<Span> &spans = shelves[shelfIndex].freeSpans;
+    int pos = 0;
+    while (pos < spans.size() && spans[pos].x < rect.x()) {
+        ++pos;
+    }
+    spans.insert(pos, Span{rect.x(), rect.width()});
+    if (pos + 1 < spans.size() && spans[pos].x + spans[pos].width == spans[pos + 1].x) {
+        spans[pos].width += spans[pos + 1].width;
+        spans.remove(pos + 1);
+    }
+    if (pos > 0 && spans[pos - 1].x + spans[pos - 1].width == spans[pos].x) {
+        spans[pos - 1].width += spans[pos].width;
+        spans.remove(pos);
+    }
+
+    // Give empty shelves at the bottom back to the page
+    while (!shelves.isEmpty()) {
+        const Shelf &last = shelves.last();
+        if (last.freeSpans.size() != 1 || last.freeSpans[0].width != size.width()) {
+            break;
+        }
+        shelfBottom = last.y;
+        shelves.removeLast();
+    }
+}
+
+void TextureAtlasPage::ensureCreated(QOpenGLFunctions *f)
+{
+    if (textureId) {
+        return;
+    }
+
+    f->glGenTextures(1, &textureId);
+    f->glBindTexture(GL_TEXTURE_2D, textureId);
+    f->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.width(), size.height(), 0,
+                    GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+void TextureAtlasPage::upload(QOpenGLFunctions *f)
+{
+    ensureCreated(f);
+    if (pending.isEmpty()) {
+        return;
+    }
+
+    f->glBindTexture(GL_TEXTURE_2D, textureId);
+    f->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (const PendingUpload &upload : pending) {
+        f->glTexSubImage2D(GL_TEXTURE_2D, 0,
+                           upload.rect.x(), upload.rect.y(),
+                           upload.rect.width(), upload.rect.height(),
+                           GL_RGBA, GL_UNSIGNED_BYTE, upload.image.constBits());
+    }
+    pending.clear();
+}
+
+// AtlasTexture
+
+AtlasTexture::AtlasTexture(TextureAtlas *atlas, TextureAtlasPage *page, const QRect &allocated, bool hasAlpha)
+    : m_atlas(atlas)
+    , m_page(page)
+    , m_allocated(allocated)
+    , m_hasAlpha(hasAlpha)
+{
+}
+
+AtlasTexture::~AtlasTexture()
+{
+    m_atlas->release(this);
+}
+
+int AtlasTexture::textureId() const
+{
+    // The renderer compares ids while batching, so every page needs its own
+    // id before the first bind or different pages would look identical
+    if (!m_page->textureId) {
+        m_atlas->createPage(m_page);
+    }
+    return m_page->textureId;
+}
+
+QSize AtlasTexture::textureSize() const
+{
+    return m_allocated.size() - QSize(2, 2);
+}
+
+QRectF AtlasTexture::normalizedTextureSubRect() const
+{
+    const QSize pageSize = m_page->size;
+    return QRectF(qreal(m_allocated.x() + 1) / pageSize.width(),
+                  qreal(m_allocated.y() + 1) / pageSize.height(),
+                  qreal(m_allocated.width() - 2) / pageSize.width(),
+                  qreal(m_allocated.height() - 2) / pageSize.height());
+}
+
+void AtlasTexture::bind()
+{
+    m_atlas->bindPage(m_page);
+    updateBindOptions(true);
+}
+
+// TextureAtlas
+
+TextureAtlas::TextureAtlas(const QSize &pageSize, int maxPages)
+    : m_pageSize(pageSize)
+    , m_maxPages(maxPages)
+{
+}
+
+TextureAtlas::~TextureAtlas()
+{
+    // Textures must be released before their atlas
+    if (textureCount() > 0) {
+        qWarning() << "TextureAtlas destroyed with live textures";
+    }
+    qDeleteAll(m_pages);
+    m_pages.clear();
+}
+
+AtlasTexture *TextureAtlas::insert(const QImage &image)
+{
+    if (image.isNull()) {
+        return nullptr;
+    }
+
+    const QSize request = image.size() + QSize(2, 2);
+    if (request.width() > m_pageSize.width() || request.height() > m_pageSize.height()) {
+        return nullptr;
+    }
+
+    // Padding and format conversion happen outside the lock
+    QImage padded = paddedImage(image);
+
+    QMutexLocker locker(&m_mutex);
+
+    QRect rect;
+    TextureAtlasPage *page = nullptr;
+    for (TextureAtlasPage *candidate : m_pages) {
+        if (candidate->allocate(request, &rect)) {
+            page = candidate;
+            break;
+        }
+    }
+    if (!page) {
+        if (m_pages.size() >= m_maxPages) {
+            return nullptr;
+        }
+        page = new TextureAtlasPage(m_pageSize);
+        m_pages.append(page);
+        if (!page->allocate(request, &rect)) {
+            return nullptr;
+        }
+    }
+
+    AtlasTexture *texture = new AtlasTexture(this, page, rect, image.hasAlphaChannel());
+    page->textures.append(texture);
+    page->pending.append(TextureAtlasPage::PendingUpload{texture, rect, padded});
+    return texture;
+}
+
+void TextureAtlas::release(AtlasTexture *texture)
+{
+    QMutexLocker locker(&m_mutex);
+
+    TextureAtlasPage *page = texture->m_page;
+    page->free(texture->m_allocated);
+    page->textures.removeOne(texture);
+    for (int i = page->pending.size() - 1; i >= 0; --i) {
+        if (page->pending[i].texture == texture) {
+            page->pending.removeAt(i);
+        }
+    }
+    // Empty pages are dropped in defragment(), where a context is current
+}
+
+void TextureAtlas::bindPage(TextureAtlasPage *page)
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (!context) {
+        return;
+    }
+    QOpenGLFunctions *f = context->functions();
+
+    QMutexLocker locker(&m_mutex);
+    page->upload(f);
+    f->glBindTexture(GL_TEXTURE_2D, page->textureId);
+}
+
+void TextureAtlas::createPage(TextureAtlasPage *page)
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (!context) {
+        return;
+    }
+    QOpenGLFunctions *f = context->functions();
+
+    // Keep the renderer's notion of the bound texture intact
+    GLint previousTexture = 0;
+    f->glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+
+    QMutexLocker locker(&m_mutex);
+    page->ensureCreated(f);
+    f->glBindTexture(GL_TEXTURE_2D, previousTexture);
+}
+
+void TextureAtlas::defragment(int maxMoves)
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (!context) {
+        return;
+    }
+    QOpenGLFunctions *f = context->functions();
+
+    QMutexLocker locker(&m_mutex);
+
+    // Pages whose textures were all released can go right away
+    for (int i = m_pages.size() - 1; i >= 0 && m_pages.size() > 1; --i) {
+        if (m_pages[i]->textures.isEmpty()) {
+            delete m_pages.takeAt(i);
+        }
+    }
+    if (m_pages.size() < 2) {
+        return;
+    }
+
+    TextureAtlasPage *source = nullptr;
+    for (TextureAtlasPage *page : m_pages) {
+        if (!source || page->usedArea < source->usedArea) {
+            source = page;
+        }
+    }
+    if (source->occupancy() > DEFRAGMENT_OCCUPANCY) {
+        return;
+    }
+
+    // Everything on the source page has to be on the GPU before copying
+    source->upload(f);
+
+    GLint previousFbo = 0;
+    f->glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+    GLuint fbo = 0;
+    f->glGenFramebuffers(1, &fbo);
+    f->glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    f->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, source->textureId, 0);
+
+    int moved = 0;
+    if (f->glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE) {
+        const QList<AtlasTexture*> textures = source->textures;
+        for (AtlasTexture *texture : textures) {
+            if (moved >= maxMoves) {
+                break;
+            }
+
+            QRect rect;
+            TextureAtlasPage *target = nullptr;
+            for (TextureAtlasPage *candidate : m_pages) {
+                if (candidate != source && candidate->allocate(texture->m_allocated.size(), &rect)) {
+                    target = candidate;
+                    break;
+                }
+            }
+            if (!target) {
+                break;
+            }
+
+            target->ensureCreated(f);
+            f->glBindTexture(GL_TEXTURE_2D, target->textureId);
+            f->glCopyTexSubImage2D(GL_TEXTURE_2D, 0, rect.x(), rect.y(),
+                                   texture->m_allocated.x(), texture->m_allocated.y(),
+                                   rect.width(), rect.height());
+
+            source->free(texture->m_allocated);
+            source->textures.removeOne(texture);
+            texture->m_page = target;
+            texture->m_allocated = rect;
+            target->textures.append(texture);
+            ++moved;
+        }
+    }
+
+    f->glBindFramebuffer(GL_FRAMEBUFFER, previousFbo);
+    f->glDeleteFramebuffers(1, &fbo);
+    f->glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (moved > 0) {
+        m_generation.ref();
+    }
+    if (source->textures.isEmpty()) {
+        m_pages.removeOne(source);
+        delete source;
+    }
+}
+
+int TextureAtlas::pageCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_pages.size();
+}
+
+int TextureAtlas::textureCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    int count = 0;
+    for (const TextureAtlasPage *page : m_pages) {
+        count += page->textures.size();
+    }
+    return count;
+}
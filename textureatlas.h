@@ -0,0 +1,79 @@
+#ifndef TEXTUREATLAS_H
+#define TEXTUREATLAS_H
+
+#include <QSGTexture>
+#include <QImage>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QRect>
+#include <QList>
+
+class TextureAtlas;
+class TextureAtlasPage;
+
+// Sub-rectangle of an atlas page. All textures on a page share the page's
+// GL texture id, so the batch renderer can merge them into one draw call.
+class AtlasTexture : public QSGTexture
+{
+public:
+    ~AtlasTexture();
+
+    int textureId() const override;
+    QSize textureSize() const override;
+    bool hasAlphaChannel() const override { return m_hasAlpha; }
+    bool hasMipmaps() const override { return false; }
+    bool isAtlasTexture() const override { return true; }
+    QRectF normalizedTextureSubRect() const override;
+    void bind() override;
+
+private:
+    friend class TextureAtlas;
+    AtlasTexture(TextureAtlas *atlas, TextureAtlasPage *page, const QRect &allocated, bool hasAlpha);
+
+    TextureAtlas *m_atlas;
+    TextureAtlasPage *m_page;
+    QRect m_allocated;      // Region on the page including the 1px padding
+    bool m_hasAlpha;
+};
+
+// Packs many small images into a few large textures using shelf packing.
+//
+// insert() only does CPU work and can be called from the GUI thread, the
+// pixels are uploaded the first time the page is bound on the render thread.
+// Releasing a texture frees its region; defragment() runs on the render
+// thread and migrates textures off sparsely used pages with a GPU copy so
+// those pages can be freed.
+class TextureAtlas
+{
+public:
+    explicit TextureAtlas(const QSize &pageSize = QSize(2048, 2048), int maxPages = 4);
+    ~TextureAtlas();
+
+    // Returns nullptr when the image does not fit, callers should fall back
+    // to a standalone texture
+    AtlasTexture *insert(const QImage &image);
+
+    // Moves at most maxMoves textures per call, needs a current GL context
+    void defragment(int maxMoves = 8);
+
+    // Bumped whenever textures move to another page, nodes using atlas
+    // textures must refresh their texture coordinates when it changes
+    int generation() const { return m_generation.load(); }
+
+    int pageCount() const;
+    int textureCount() const;
+
+private:
+    friend class AtlasTexture;
+    void release(AtlasTexture *texture);
+    void bindPage(TextureAtlasPage *page);
+    void createPage(TextureAtlasPage *page);
+
+    mutable QMutex m_mutex;
+    QSize m_pageSize;
+    int m_maxPages;
+    QList<TextureAtlasPage*> m_pages;
+    QAtomicInt m_generation;
+};
+
+#endif // TEXTUREATLAS_H
@@ -0,0 +1,109 @@
+#include "textureresidencymanager.h"
+#include <QVector>
+#include <QPair>
+#include <algorithm>
+#include <limits>
+
+namespace {
+// Evicting stops this far below the budget, so the next few uploads don't
+// each evict again
+const qreal LOW_WATERMARK = 0.85;
+const qreal UNRANKED = std::numeric_limits<qreal>::max();
+}
+
+TextureResidencyManager::TextureResidencyManager(qint64 budgetBytes)
+    : m_budget(qMax<qint64>(0, budgetBytes))
+    , m_bytes(0)
+    , m_evictions(0)
+{
+}
+
+void TextureResidencyManager::insert(const QString &key, QSGTexture *texture, qint64 bytes)
+{
+    if (!texture || m_entries.contains(texture)) {
+        return;
+    }
+    // Just loaded for an item close by, safe until the next ranking
+    m_textures.insert(key, texture);
+    m_entries.insert(texture, Entry{ key, bytes, 0, 0, true });
+    m_bytes += bytes;
+}
+
+void TextureResidencyManager::addRef(QSGTexture *texture)
+{
+    auto it = m_entries.find(texture);
+    if (it != m_entries.end()) {
+        ++it->refCount;
+    }
+}
+
+void TextureResidencyManager::release(QSGTexture *texture)
+{
+    auto it = m_entries.find(texture);
+    if (it != m_entries.end() && it->refCount > 0 && --it->refCount == 0) {
+        // No item shows it anymore, first to go until the next ranking
+        it->priority = UNRANKED;
+        it->pinned = false;
+    }
+}
+
+void TextureResidencyManager::resetRanks()
+{
+    for (Entry &entry : m_entries) {
+        entry.priority = UNRANKED;
+        entry.pinned = false;
+    }
+}
+
+void TextureResidencyManager::rank(QSGTexture *texture, qreal priority, bool pinned)
+{
+    // Shared textures count as close as their closest item
+    auto it = m_entries.find(texture);
+    if (it != m_entries.end()) {
+        it->priority = qMin(it->priority, priority);
+        it->pinned |= pinned;
+    }
+}
+
+QList<QSGTexture*> TextureResidencyManager::evict()
+{
+    QList<QSGTexture*> evicted;
+    if (!isOverBudget()) {
+        return evicted;
+    }
+
+    // Farthest first, textures no item shows were not ranked at all
+    QVector<QPair<qreal, QSGTexture*>> candidates;
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        if (!it->pinned) {
+            candidates.append(qMakePair(it->priority, it.key()));
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const QPair<qreal, QSGTexture*> &a, const QPair<qreal, QSGTexture*> &b) {
+                  return a.first > b.first;
+              });
+
+    const qint64 target = qint64(m_budget * LOW_WATERMARK);
+    for (const auto &candidate : candidates) {
+        if (m_bytes <= target) {
+            break;
+        }
+        auto it = m_entries.find(candidate.second);
+        m_bytes -= it->bytes;
+        m_textures.remove(it->key);
+        m_entries.erase(it);
+        evicted.append(candidate.second);
+        ++m_evictions;
+    }
+    return evicted;
+}
+
+QList<QSGTexture*> TextureResidencyManager::takeAll()
+{
+    QList<QSGTexture*> textures = m_entries.keys();
+    m_textures.clear();
+    m_entries.clear();
+    m_bytes = 0;
+    return textures;
+}
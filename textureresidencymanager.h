@@ -0,0 +1,74 @@
+#ifndef TEXTURERESIDENCYMANAGER_H
+#define TEXTURERESIDENCYMANAGER_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+
+class QSGTexture;
+
+// Keeps the poster textures of a view within a GPU memory budget.
+//
+// Textures are keyed like the loads that produced them (image and decoded
+// size) and handed out refcounted: every item showing one holds a
+// reference. Unreferenced textures stay resident, so posters scrolling back
+// in need no upload, until the budget runs out.
+//
+// The view ranks the textures after every reprioritization, by distance to
+// the viewport and focus, and pins the ones close enough that they would
+// be loaded again right away. Once the budget is exceeded, evict() drops
+// the farthest unpinned textures, referenced or not, until the resident
+// bytes are well below the budget. Pinning further out than loads reach and
+// evicting down to a low watermark keeps scrolling back and forth from
+// evicting and reloading the same posters.
+//
+// Evicted textures are handed back to the caller, which detaches them from
+// its items and deletes them on the render thread. GUI thread only.
+class TextureResidencyManager
+{
+public:
+    explicit TextureResidencyManager(qint64 budgetBytes);
+
+    // Resident texture for key, null if none
+    QSGTexture *find(const QString &key) const { return m_textures.value(key, nullptr); }
+    // Takes over a new texture with no references yet
+    void insert(const QString &key, QSGTexture *texture, qint64 bytes);
+    bool contains(QSGTexture *texture) const { return m_entries.contains(texture); }
+    // Every item showing the texture holds one reference
+    void addRef(QSGTexture *texture);
+    // The texture stays resident without references
+    void release(QSGTexture *texture);
+
+    // Ranking pass: unranked textures count as farthest away. Lower
+    // priorities matter more; pinned textures are never evicted.
+    void resetRanks();
+    void rank(QSGTexture *texture, qreal priority, bool pinned);
+
+    bool isOverBudget() const { return m_bytes > m_budget; }
+    QList<QSGTexture*> evict();
+    // Everything, e.g. when the scene graph goes away
+    QList<QSGTexture*> takeAll();
+
+    void setBudget(qint64 bytes) { m_budget = qMax<qint64>(0, bytes); }
+    qint64 budget() const { return m_budget; }
+    qint64 bytes() const { return m_bytes; }
+    int count() const { return m_entries.size(); }
+    int evictions() const { return m_evictions; }
+
+private:
+    struct Entry {
+        QString key;
+        qint64 bytes;
+        int refCount;
+        qreal priority;
+        bool pinned;
+    };
+
+    QHash<QString, QSGTexture*> m_textures;
+    QHash<QSGTexture*, Entry> m_entries;
+    qint64 m_budget;
+    qint64 m_bytes;
+    int m_evictions;
+};
+
+#endif // TEXTURERESIDENCYMANAGER_H
@@ -0,0 +1,208 @@
+#include "titletexturecache.h"
+#include "textureatlas.h"
+#include <QQuickWindow>
+#include <QSGTexture>
+#include <QPainter>
+#include <QFontMetrics>
+#include <QDebug>
+#include <cmath>
+
+TitleTextureCache& TitleTextureCache::instance()
+{
+    static TitleTextureCache cache;
+    return cache;
+}
+
+TitleTextureCache::TitleTextureCache()
+    : m_useCounter(0)
+{
+}
+
+TitleTextureCache::~TitleTextureCache()
+{
+    // Windows are gone by now, just free the CPU side
+    QList<QQuickWindow*> windows = m_windows.keys();
+    for (QQuickWindow* window : windows) {
+        invalidate(window);
+    }
+}
+
+QSGTexture* TitleTextureCache::acquire(QQuickWindow* window, const QString& text, const QFont& font,
+                                       const QColor& color, int height, QSizeF* logicalSize)
+{
+    if (!window || text.isEmpty() || height <= 0) {
+        return nullptr;
+    }
+
+    const qreal dpr = window->devicePixelRatio();
+    const QString key = text + QLatin1Char('\x1f') + font.key()
+                      + QLatin1Char('\x1f') + QString::number(color.rgba(), 16)
+                      + QLatin1Char('\x1f') + QString::number(dpr)
+                      + QLatin1Char('\x1f') + QString::number(height);
+
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_windows.contains(window)) {
+        WindowCache cache;
+        // One strip texture is plenty for the row titles of a window
+        cache.atlas = new TextureAtlas(QSize(2048, 512), 1);
+        cache.unusedCount = 0;
+        m_windows.insert(window, cache);
+
+        // Textures die with the scene graph, drop them before the context goes
+        QObject::connect(window, &QQuickWindow::sceneGraphInvalidated, [this, window]() {
+            invalidate(window);
+        });
+        QObject::connect(window, &QObject::destroyed, [this, window]() {
+            invalidate(window);
+        });
+    }
+    WindowCache& cache = m_windows[window];
+
+    auto it = cache.entries.find(key);
+    if (it != cache.entries.end()) {
+        if (it->refCount++ == 0) {
+            --cache.unusedCount;
+        }
+        it->lastUsed = ++m_useCounter;
+        if (logicalSize) {
+            *logicalSize = it->logicalSize;
+        }
+        return it->texture;
+    }
+
+    QSizeF size;
+    QImage image = rasterize(text, font, color, height, dpr, &size);
+    if (image.isNull()) {
+        return nullptr;
+    }
+
+    QSGTexture* texture = cache.atlas->insert(image);
+    if (!texture) {
+        // Strip is full, a standalone texture still beats re-rasterizing
+        texture = window->createTextureFromImage(image, QQuickWindow::TextureHasAlphaChannel);
+    }
+    if (!texture) {
+        return nullptr;
+    }
+
+    TitleEntry entry;
+    entry.texture = texture;
+    entry.logicalSize = size;
+    entry.refCount = 1;
+    entry.lastUsed = ++m_useCounter;
+    cache.entries.insert(key, entry);
+    cache.keys.insert(texture, key);
+
+    if (logicalSize) {
+        *logicalSize = size;
+    }
+    return texture;
+}
+
+void TitleTextureCache::release(QSGTexture* texture)
+{
+    if (!texture) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    for (auto windowIt = m_windows.begin(); windowIt != m_windows.end(); ++windowIt) {
+        WindowCache& cache = windowIt.value();
+        auto keyIt = cache.keys.constFind(texture);
+        if (keyIt == cache.keys.constEnd()) {
+            continue;
+        }
+
+        TitleEntry& entry = cache.entries[keyIt.value()];
+        if (--entry.refCount == 0) {
+            ++cache.unusedCount;
+            trimUnused(cache);
+        }
+        return;
+    }
+}
+
+int TitleTextureCache::textureCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    int count = 0;
+    for (const WindowCache& cache : m_windows) {
+        count += cache.entries.size();
+    }
+    return count;
+}
+
+QImage TitleTextureCache::rasterize(const QString& text, const QFont& font, const QColor& color,
+                                    int height, qreal dpr, QSizeF* logicalSize) const
+{
+    QFontMetrics fm(font);
+    int width = fm.width(text) + 20;  // Add 20px padding
+
+    QImage textImage(int(std::ceil(width * dpr)), int(std::ceil(height * dpr)),
+                     QImage::Format_ARGB32_Premultiplied);
+    if (textImage.isNull()) {
+        return QImage();
+    }
+    textImage.setDevicePixelRatio(dpr);
+    textImage.fill(Qt::transparent);
+
+    QPainter painter;
+    if (!painter.begin(&textImage)) {
+        return QImage();
+    }
+    painter.setFont(font);
+    painter.setPen(color);
+    painter.setRenderHints(QPainter::TextAntialiasing | QPainter::SmoothPixmapTransform);
+
+    // Draw text with left alignment and vertical centering
+    int yPos = (height + fm.ascent() - fm.descent()) / 2;
+    painter.drawText(10, yPos, text);
+    painter.end();
+
+    *logicalSize = QSizeF(width, height);
+    return textImage;
+}
+
+void TitleTextureCache::trimUnused(WindowCache& cache)
+{
+    // Drop the least recently used titles nobody references
+    while (cache.unusedCount > MAX_UNUSED_TITLES) {
+        auto oldest = cache.entries.end();
+        for (auto it = cache.entries.begin(); it != cache.entries.end(); ++it) {
+            if (it->refCount == 0 && (oldest == cache.entries.end() || it->lastUsed < oldest->lastUsed)) {
+                oldest = it;
+            }
+        }
+        if (oldest == cache.entries.end()) {
+            break;
+        }
+        cache.keys.remove(oldest->texture);
+        delete oldest->texture;
+        cache.entries.erase(oldest);
+        --cache.unusedCount;
+    }
+}
+
+void TitleTextureCache::invalidate(QQuickWindow* window)
+{
+    // Emitted on the render thread with the context still current
+    QMutexLocker locker(&m_mutex);
+    auto it = m_windows.find(window);
+    if (it == m_windows.end()) {
+        return;
+    }
+
+    int referenced = 0;
+    for (const TitleEntry& entry : it->entries) {
+        if (entry.refCount > 0) {
+            ++referenced;
+        }
+        delete entry.texture;
+    }
+    if (referenced > 0) {
+        qWarning() << "TitleTextureCache: dropping" << referenced << "titles still in use";
+    }
+    delete it->atlas;
+    m_windows.erase(it);
+}
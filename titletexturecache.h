@@ -0,0 +1,68 @@
+#ifndef TITLETEXTURECACHE_H
+#define TITLETEXTURECACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QFont>
+#include <QColor>
+#include <QSizeF>
+#include <QImage>
+
+class QQuickWindow;
+class QSGTexture;
+class TextureAtlas;
+
+// Rasterized row titles shared by every CustomImageListView in a window.
+//
+// Titles are keyed by (text, font, color, device pixel ratio, height) and
+// packed into one shared strip texture, so steady state frames never touch
+// QPainter. Textures are refcounted; unused titles stay cached up to a limit
+// so rows scrolling back in are free. Must be used on the render thread.
+class TitleTextureCache
+{
+public:
+    static TitleTextureCache& instance();
+
+    // Returns the cached texture for the title and its size in logical pixels.
+    // Every successful acquire() must be balanced by a release().
+    QSGTexture* acquire(QQuickWindow* window, const QString& text, const QFont& font,
+                        const QColor& color, int height, QSizeF* logicalSize);
+    void release(QSGTexture* texture);
+
+    int textureCount() const;
+
+private:
+    TitleTextureCache();
+    ~TitleTextureCache();
+    TitleTextureCache(const TitleTextureCache&) = delete;
+    TitleTextureCache& operator=(const TitleTextureCache&) = delete;
+
+    struct TitleEntry {
+        QSGTexture* texture;
+        QSizeF logicalSize;
+        int refCount;
+        quint64 lastUsed;
+    };
+
+    // Per window, since textures belong to the window's GL context
+    struct WindowCache {
+        TextureAtlas* atlas;
+        QHash<QString, TitleEntry> entries;
+        QHash<QSGTexture*, QString> keys;
+        int unusedCount;
+    };
+
+    QImage rasterize(const QString& text, const QFont& font, const QColor& color,
+                     int height, qreal dpr, QSizeF* logicalSize) const;
+    void trimUnused(WindowCache& cache);
+    void invalidate(QQuickWindow* window);
+
+    QHash<QQuickWindow*, WindowCache> m_windows;
+    mutable QMutex m_mutex;
+    quint64 m_useCounter;
+
+    static constexpr int MAX_UNUSED_TITLES = 64;
+};
+
+#endif // TITLETEXTURECACHE_H